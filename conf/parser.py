@@ -28,6 +28,21 @@ class Parser:
         self.ip_frag_with_eth_mtu = None
         self.hwcksum = False
         self.gtppsc = False
+        self.tcp_mss_clamp = False
+        self.gtpu_gso = False
+        self.two_stage_pdr = False
+        self.fused_session_table = False
+        self.ue_pools = []
+        self.teid_base = 0
+        self.teid_range = 0
+        self.session_filter = False
+        self.dl_buffer = False
+        self.ddn_holddown_ms = 0
+        self.end_marker_module = False
+        self.gtpu_error_indication = False
+        self.module_stats = False
+        self.latency_sample_every = 0
+        self.capture_tap = None
         self.ddp = False
         self.measure = False
         self.mode = None
@@ -49,6 +64,7 @@ class Parser:
         self.enable_ntf = False
         self.notify_sockaddr = "/tmp/notifycp"
         self.endmarker_sockaddr = "/tmp/pfcpport"
+        self.gtpu_signal_sockaddr = None
 
     def parse(self, ifaces):
         # Maximum number of flows to manage ip4 frags for re-assembly
@@ -75,6 +91,96 @@ class Parser:
         except KeyError:
             print('gtppsc not set. Default: Not adding PDU Session Container extension header')
 
+        # Enable TCP MSS clamping
+        try:
+            self.tcp_mss_clamp = bool(self.conf["tcp_mss_clamp"])
+        except KeyError:
+            print('tcp_mss_clamp not set. Default: Not installing TcpMssClamp modules')
+
+        # Enable segmentation of encapsulated TCP super-packets
+        try:
+            self.gtpu_gso = bool(self.conf["gtpu_gso"])
+        except KeyError:
+            print('gtpu_gso not set. Default: Not installing GtpuGso module')
+
+        # Classify PDRs by session first
+        try:
+            self.two_stage_pdr = bool(self.conf["two_stage_pdr"])
+        except KeyError:
+            print('two_stage_pdr not set. Default: Using WildcardMatch for pdrLookup')
+
+        # Keep QERs and FARs in the session table
+        try:
+            self.fused_session_table = bool(self.conf["fused_session_table"])
+        except KeyError:
+            print('fused_session_table not set. Default: Using separate qerLookup and farLookup')
+
+        # Look up downlink sessions in the UE pool by direct index
+        try:
+            if bool(self.conf["direct_ue_lookup"]):
+                self.ue_pools = [self.conf["cpiface"]["ue_ip_pool"]]
+        except KeyError:
+            print('direct_ue_lookup or ue_ip_pool not set. Default: Hashing UE addresses in pdrLookup')
+
+        # Look up uplink sessions of UPF-allocated TEIDs by direct index
+        try:
+            self.teid_base = int(self.conf["teid_base"], 16)
+            self.teid_range = int(self.conf["teid_range"])
+        except ValueError:
+            print('Invalid teid_base/teid_range value!')
+        except KeyError:
+            print('teid_base/teid_range not set. Default: Hashing TEIDs in pdrLookup')
+
+        # Drop packets of unknown TEIDs/UE addresses ahead of pdrLookup
+        try:
+            self.session_filter = bool(self.conf["session_filter"])
+        except KeyError:
+            print('session_filter not set. Default: Not installing SessionFilter module')
+
+        # Buffer downlink packets of idle UEs instead of dropping them
+        try:
+            self.dl_buffer = bool(self.conf["dl_buffer"])
+        except KeyError:
+            print('dl_buffer not set. Default: Dropping packets of buffering FARs')
+
+        # Rate-limit and batch downlink data notifications
+        try:
+            self.ddn_holddown_ms = int(self.conf["ddn_holddown_ms"])
+        except ValueError:
+            print('Invalid value for ddn_holddown_ms. Not installing DdnNotify module.')
+        except KeyError:
+            print('ddn_holddown_ms not set. Default: One notification per packet')
+
+        # Build end markers in the dataplane
+        try:
+            self.end_marker_module = bool(self.conf["end_marker_module"])
+        except KeyError:
+            print('end_marker_module not set. Default: End markers come from pfcpiface over pfcpPort')
+
+        # Answer G-PDUs of unknown TEIDs with error indications
+        try:
+            self.gtpu_error_indication = bool(self.conf["gtpu_error_indication"])
+        except KeyError:
+            print('gtpu_error_indication not set. Default: Drop G-PDUs of unknown TEIDs silently')
+
+        # Count cycles per batch/packet in the UPF modules
+        try:
+            self.module_stats = bool(self.conf["module_stats"])
+        except KeyError:
+            print('module_stats not set. Default: No per-module cycle accounting')
+
+        # Sample per-session latency
+        try:
+            self.latency_sample_every = int(self.conf["latency_sample_every"])
+        except KeyError:
+            print('latency_sample_every not set. Default: No per-session latency')
+
+        # Insert a packet capture tap
+        try:
+            self.capture_tap = self.conf["capture_tap"]
+        except KeyError:
+            print('capture_tap not set. Default: No capture tap')
+
         # Enable hardware checksum
         try:
             self.hwcksum = bool(self.conf["hwcksum"])
@@ -162,6 +268,12 @@ class Parser:
         except KeyError:
             print('Can\'t parse unix socket paths for end marker! Setting it to default values ({})'.format(
                 "/tmp/pfcpport"))
+
+        # UnixPort Paths
+        try:
+            self.gtpu_signal_sockaddr = self.conf["gtpu_signal_sockaddr"]
+        except KeyError:
+            print('gtpu_signal_sockaddr not set. Default: Drop GTP-U error indications and end markers')
         # Network Token Function
         try:
             self.enable_ntf = bool(self.conf['enable_ntf'])
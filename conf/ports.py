@@ -230,16 +230,22 @@ class Port:
         # Finall set conf mode
         self.mode = conf_mode
 
-    def setup_port(self, conf_frag_mtu, conf_defrag_flows, conf_measure, type_of_packets = "", **seq_kwargs):
+    def setup_port(self, conf_frag_mtu, conf_defrag_flows, conf_measure, type_of_packets = "", drop = None, **seq_kwargs):
         out = self.fpo
         inc = self.fpi
         gate = 0
 
+        # Drops go to drop(module, ogate, reason) if given, else to a Sink named after the reason
+        def sink(module, ogate, reason):
+            if drop is not None:
+                drop(module, ogate, reason)
+            else:
+                module.connect(next_mod=Sink(name=reason), ogate=ogate)
+
         # enable frag module (if enabled) to control port MTU size
         if conf_frag_mtu is not None:
             frag = IPFrag(name="{}IP4Frag".format(self.name), mtu=conf_frag_mtu)
-            s = Sink(name="{}IP4FragFail".format(self.name))
-            frag.connect(next_mod=s)
+            sink(frag, 0, "{}IP4FragFail".format(self.name))
             frag.connect(next_mod=out, ogate=1)
             out = frag
 
@@ -270,8 +276,7 @@ class Port:
 
         if conf_defrag_flows is not None:
             defrag = IPDefrag(name="{}IP4Defrag".format(self.name), num_flows=conf_defrag_flows, numa=-1)
-            s = Sink(name="{}DefragFail".format(self.name))
-            defrag.connect(next_mod=s)
+            sink(defrag, 0, "{}DefragFail".format(self.name))
             inc.connect(next_mod=defrag)
             inc = defrag
             gate = 1
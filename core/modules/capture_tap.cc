@@ -0,0 +1,272 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for capture_tap decls */
+#include "capture_tap.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for be32_t */
+#include "utils/endian.h"
+/* for rdtsc() and tsc_to_ns() */
+#include "utils/time.h"
+/* for rte_mbuf_refcnt_update() */
+#include <rte_mbuf.h>
+#include <time.h>
+#include <unistd.h>
+/*----------------------------------------------------------------------------------*/
+using bess::utils::be32_t;
+
+/* defaults of the CaptureTapArg fields */
+static const uint32_t kDefaultRingSize = 1024;
+
+/* how long the writer sleeps on empty rings */
+static const useconds_t kWriterIdleUs = 1000;
+
+/* pcapng block types and the link type of Ethernet */
+static const uint32_t kSectionHeaderBlock = 0x0A0D0D0A;
+static const uint32_t kInterfaceDescBlock = 1;
+static const uint32_t kEnhancedPacketBlock = 6;
+static const uint32_t kByteOrderMagic = 0x1A2B3C4D;
+static const uint16_t kLinkTypeEthernet = 1;
+
+const Commands CaptureTap::cmds = {
+    {"arm", "CaptureTapCommandArmArg", MODULE_CMD_FUNC(&CaptureTap::CommandArm),
+     Command::THREAD_SAFE},
+    {"disarm", "EmptyArg", MODULE_CMD_FUNC(&CaptureTap::CommandDisarm),
+     Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  if (__builtin_expect(__atomic_load_n(&armed_, __ATOMIC_ACQUIRE), 0))
+    Capture(ctx, batch);
+
+  RunNextModule(ctx, batch);
+}
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::Capture(Context *ctx, bess::PacketBatch *batch) {
+  WorkerRing &r = rings_[ctx->wid];
+
+  for (int i = 0; i < batch->cnt(); i++) {
+    bess::Packet *p = batch->pkts()[i];
+    bool match;
+
+    switch (filter_) {
+      case TEID:
+        match = get_attr<uint32_t>(this, teid_attr_, p) == value_;
+        break;
+      case UE_IP:
+        match = get_attr<uint32_t>(this, src_ip_attr_, p) == value_ ||
+                get_attr<uint32_t>(this, dst_ip_attr_, p) == value_;
+        break;
+      case CTR_ID:
+        match = get_attr<uint32_t>(this, ctr_attr_, p) == value_;
+        break;
+      default:
+        match = true;
+    }
+    if (!match)
+      continue;
+
+    Captured c = {p, p->head_data<void *>(), (uint32_t)p->head_len(),
+                  (uint32_t)p->total_len(), ctx->current_ns};
+    /* the writer drops this reference, whatever happens to p here */
+    rte_mbuf_refcnt_update(reinterpret_cast<struct rte_mbuf *>(p), 1);
+    if (!r.ring.Push(c)) {
+      rte_mbuf_refcnt_update(reinterpret_cast<struct rte_mbuf *>(p), -1);
+      r.full++;
+    }
+  }
+}
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::WritePacket(const Captured &c) {
+  uint32_t len = c.len < snaplen_ ? c.len : snaplen_;
+  uint32_t pad = (4 - (len & 3)) & 3;
+  uint32_t total = 32 + len + pad;
+  uint64_t ns = c.ns + wall_offset_ns_;
+  uint32_t hdr[7] = {kEnhancedPacketBlock,
+                     total,
+                     0, /* interface */
+                     (uint32_t)(ns >> 32),
+                     (uint32_t)ns,
+                     len,
+                     c.wire};
+  static const uint8_t zeros[3] = {};
+
+  fwrite(hdr, sizeof(hdr), 1, file_);
+  fwrite(c.data, len, 1, file_);
+  fwrite(zeros, pad, 1, file_);
+  fwrite(&total, sizeof(total), 1, file_);
+}
+/*----------------------------------------------------------------------------------*/
+size_t CaptureTap::Drain() {
+  size_t n = 0;
+  Captured c;
+
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++) {
+    while (rings_[wid].ring.Pop(&c)) {
+      if (file_ != nullptr) {
+        WritePacket(c);
+        if (++written_ == max_packets_) {
+          __atomic_store_n(&armed_, false, __ATOMIC_RELEASE);
+          Close();
+        }
+      }
+      bess::Packet::Free(c.pkt);
+      n++;
+    }
+  }
+  if (n > 0 && file_ != nullptr)
+    fflush(file_);
+
+  return n;
+}
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::Close() {
+  if (file_ != nullptr) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+}
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::Writer() {
+  while (!__atomic_load_n(&stop_, __ATOMIC_ACQUIRE)) {
+    size_t n;
+    {
+      std::lock_guard<std::mutex> guard(lock_);
+      n = Drain();
+    }
+    if (n == 0)
+      usleep(kWriterIdleUs);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse CaptureTap::CommandArm(
+    const bess::pb::CaptureTapCommandArmArg &arg) {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  if (__atomic_load_n(&armed_, __ATOMIC_ACQUIRE))
+    return CommandFailure(EBUSY, "Already armed, disarm first");
+
+  switch (arg.filter_case()) {
+    case bess::pb::CaptureTapCommandArmArg::kTeid:
+      filter_ = TEID;
+      value_ = be32_t(arg.teid()).raw_value();
+      break;
+    case bess::pb::CaptureTapCommandArmArg::kUeIp:
+      filter_ = UE_IP;
+      value_ = be32_t(arg.ue_ip()).raw_value();
+      break;
+    case bess::pb::CaptureTapCommandArmArg::kCtrId:
+      if (!has_ctr_id_)
+        return CommandFailure(EINVAL, "No ctr_id at this tap");
+      filter_ = CTR_ID;
+      value_ = arg.ctr_id();
+      break;
+    default:
+      filter_ = ALL;
+  }
+
+  /* stragglers of the previous capture aren't written into this one */
+  Close();
+  Drain();
+
+  file_ = fopen(arg.path().c_str(), "w");
+  if (file_ == nullptr)
+    return CommandFailure(errno, "Unable to open '%s'", arg.path().c_str());
+
+  snaplen_ = arg.snaplen() ?: 65535;
+  max_packets_ = arg.max_packets();
+  written_ = 0;
+
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  wall_offset_ns_ = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec -
+                    (int64_t)tsc_to_ns(rdtsc());
+
+  /* one section of one Ethernet interface, timestamps in ns */
+  struct {
+    uint32_t type, len, magic;
+    uint16_t major, minor;
+    uint32_t section_len[2]; /* -1: unknown */
+    uint32_t len_again;
+  } shb = {kSectionHeaderBlock, sizeof(shb), kByteOrderMagic, 1, 0,
+           {0xFFFFFFFF, 0xFFFFFFFF}, sizeof(shb)};
+  struct {
+    uint32_t type, len;
+    uint16_t link_type, reserved;
+    uint32_t snaplen;
+    uint16_t tsresol_code, tsresol_len; /* if_tsresol option */
+    uint8_t tsresol, pad[3];
+    uint32_t end_of_opt, len_again;
+  } idb = {kInterfaceDescBlock, sizeof(idb), kLinkTypeEthernet, 0, snaplen_,
+           9, 1, 9 /* 10^-9 */, {}, 0, sizeof(idb)};
+  fwrite(&shb, sizeof(shb), 1, file_);
+  fwrite(&idb, sizeof(idb), 1, file_);
+  fflush(file_);
+
+  if (!writer_.joinable())
+    writer_ = std::thread(&CaptureTap::Writer, this);
+
+  __atomic_store_n(&armed_, true, __ATOMIC_RELEASE);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse CaptureTap::CommandDisarm(const bess::pb::EmptyArg &) {
+  __atomic_store_n(&armed_, false, __ATOMIC_RELEASE);
+
+  std::lock_guard<std::mutex> guard(lock_);
+  Drain();
+  Close();
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse CaptureTap::Init(const bess::pb::CaptureTapArg &arg) {
+  ring_size_ = arg.ring_size() ?: kDefaultRingSize;
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++) {
+    if (!rings_[wid].ring.Init(ring_size_)) {
+      for (int i = 0; i < wid; i++)
+        rings_[i].ring.Free();
+      return CommandFailure(ENOMEM, "Unable to allocate capture rings");
+    }
+  }
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  teid_attr_ = AddMetadataAttr("teid", sizeof(uint32_t), AccessMode::kRead);
+  src_ip_attr_ = AddMetadataAttr("src_ip", sizeof(uint32_t), AccessMode::kRead);
+  dst_ip_attr_ = AddMetadataAttr("dst_ip", sizeof(uint32_t), AccessMode::kRead);
+  has_ctr_id_ = arg.ctr_id();
+  if (has_ctr_id_)
+    ctr_attr_ = AddMetadataAttr("ctr_id", sizeof(uint32_t), AccessMode::kRead);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void CaptureTap::DeInit() {
+  __atomic_store_n(&armed_, false, __ATOMIC_RELEASE);
+  __atomic_store_n(&stop_, true, __ATOMIC_RELEASE);
+  if (writer_.joinable())
+    writer_.join();
+
+  Drain();
+  Close();
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++)
+    rings_[wid].ring.Free();
+}
+/*----------------------------------------------------------------------------------*/
+std::string CaptureTap::GetDesc() const {
+  uint64_t full = 0;
+
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++)
+    full += rings_[wid].full;
+
+  std::lock_guard<std::mutex> guard(lock_);
+  return bess::utils::Format(
+      "%s, %lu packets written, %lu skipped",
+      __atomic_load_n(&armed_, __ATOMIC_ACQUIRE) ? "armed" : "disarmed",
+      written_, full);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(CaptureTap, "capture_tap",
+           "writes the packets of one session into a pcapng file")
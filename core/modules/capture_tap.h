@@ -0,0 +1,98 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_CAPTURETAP_H_
+#define BESS_MODULES_CAPTURETAP_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for SpscRing */
+#include "../utils/spsc_ring.h"
+#include <cstdio>
+#include <mutex>
+#include <thread>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Passes packets through, and once armed with `arm' writes the ones of one
+ * TEID, UE address or ctr_id into a pcapng file, until `disarm' or until
+ * max_packets are written. Unarmed, it costs one branch per batch.
+ *
+ * Matching packets aren't copied: workers take a reference to the mbuf and
+ * push it into their own SPSC ring, and a background thread drains the rings
+ * into the file and drops the references. Only the bytes in front of the
+ * packet at capture time are written, but modules downstream that rewrite
+ * headers in place (MACs, checksums) may do so before the thread reads
+ * them. When a ring is full, the capture (never the packet) is skipped.
+ *
+ * It reads the teid, src_ip and dst_ip attributes of GtpuParser, and ctr_id
+ * if told so, for taps placed after PdrLookup.
+ */
+class CaptureTap final : public Module {
+ public:
+  CaptureTap() : armed_(false), stop_(false), file_(nullptr) {
+    max_allowed_workers_ = Worker::kMaxWorkers;
+  }
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::CaptureTapArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns whether it is armed and the number of packets written
+  std::string GetDesc() const override;
+
+  CommandResponse CommandArm(const bess::pb::CaptureTapCommandArmArg &arg);
+  CommandResponse CommandDisarm(const bess::pb::EmptyArg &);
+
+ private:
+  /* what a worker hands over to the writer */
+  struct Captured {
+    bess::Packet *pkt;
+    const void *data;
+    uint32_t len;  /* of data */
+    uint32_t wire; /* packet length */
+    uint64_t ns;
+  };
+
+  struct alignas(64) WorkerRing {
+    bess::utils::SpscRing<Captured> ring;
+    uint64_t full; /* captures skipped */
+  };
+
+  enum Filter { ALL, TEID, UE_IP, CTR_ID };
+
+  void Capture(Context *ctx, bess::PacketBatch *batch);
+  /* writer thread */
+  void Writer();
+  /* empties the rings into file_ (if open), returns the number of entries */
+  size_t Drain();
+  void WritePacket(const Captured &c);
+  void Close();
+
+  /* set by commands, read by workers once armed_ is */
+  bool armed_;
+  Filter filter_ = ALL;
+  uint32_t value_ = 0; /* in the byte order of the attribute */
+  uint32_t snaplen_ = 0;
+
+  WorkerRing rings_[Worker::kMaxWorkers] = {};
+  uint32_t ring_size_ = 0;
+
+  bool stop_;
+  std::thread writer_;
+
+  /* held by whoever drains: the writer, `disarm', DeInit() */
+  mutable std::mutex lock_;
+  FILE *file_;
+  uint64_t written_ = 0;
+  uint64_t max_packets_ = 0;
+  int64_t wall_offset_ns_ = 0; /* from ctx->current_ns to the wall clock */
+
+  bool has_ctr_id_ = false;
+  int teid_attr_ = -1;
+  int src_ip_attr_ = -1;
+  int dst_ip_attr_ = -1;
+  int ctr_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_CAPTURETAP_H_
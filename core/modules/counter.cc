@@ -7,6 +7,8 @@
 #include "utils/format.h"
 /* for endian functions */
 #include <arpa/inet.h>
+/* for rdtsc() */
+#include "utils/time.h"
 /*----------------------------------------------------------------------------------*/
 const Commands Counter::cmds = {
     {"add", "CounterAddArg", MODULE_CMD_FUNC(&Counter::AddCounter),
@@ -14,7 +16,13 @@ const Commands Counter::cmds = {
     {"removeAll", "EmptyArg", MODULE_CMD_FUNC(&Counter::RemoveAllCounters),
      Command::THREAD_SAFE},
     {"remove", "CounterRemoveArg", MODULE_CMD_FUNC(&Counter::RemoveCounter),
-     Command::THREAD_SAFE}};
+     Command::THREAD_SAFE},
+    {"get_latency", "CounterCommandGetLatencyArg",
+     MODULE_CMD_FUNC(&Counter::GetLatency), Command::THREAD_SAFE},
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&Counter::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&Counter::CommandSetStats), Command::THREAD_SAFE}};
 /*----------------------------------------------------------------------------------*/
 CommandResponse Counter::AddCounter(const bess::pb::CounterAddArg &arg) {
   uint32_t ctr_id = arg.ctr_id();
@@ -26,7 +34,8 @@ CommandResponse Counter::AddCounter(const bess::pb::CounterAddArg &arg) {
   } else
     return CommandFailure(EINVAL, "Unable to add ctr");
 #else
-  (void)ctr_id;
+  if (ctr_id >= total_count)
+    return CommandFailure(ENOSPC, "Out of counters");
   curr_count++;
 #endif
   return CommandSuccess();
@@ -64,6 +73,8 @@ CommandResponse Counter::RemoveCounter(const bess::pb::CounterRemoveArg &arg) {
   }
   curr_count--;
 #endif
+  if (latency != nullptr && ctr_id < latency_count)
+    memset(&latency[ctr_id], 0, sizeof(SessionLatency));
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
@@ -86,10 +97,63 @@ CommandResponse Counter::Init(const bess::pb::CounterArg &arg) {
   curr_count = 0;
 #endif
 
+  if (arg.latency()) {
+    latency_count = arg.total();
+    if (latency_count == 0)
+      return CommandFailure(EINVAL, "Invalid total number");
+    latency = (SessionLatency *)calloc(latency_count, sizeof(SessionLatency));
+    if (latency == NULL)
+      return CommandFailure(ENOMEM, "Unable to allocate memory for latency!");
+    ts_attr_id = AddMetadataAttr("ts", sizeof(uint64_t), AccessMode::kRead);
+  }
+
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
+void Counter::DeInit() {
+  free(latency);
+  latency = nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+static inline int LatencyBucket(uint64_t ns) {
+  int i = 63 - __builtin_clzll((ns / kLatencyMinNs) | 1);
+  return i < kLatencyBuckets ? i : kLatencyBuckets - 1;
+}
+/*----------------------------------------------------------------------------------*/
+void Counter::RecordLatency(bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+  uint64_t now = 0;
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    uint64_t ts = get_attr<uint64_t>(this, ts_attr_id, p);
+    if (ts == 0)
+      continue;
+    uint32_t ctr_id = get_attr<uint32_t>(this, ctr_attr_id, p);
+    if (ctr_id >= latency_count)
+      continue;
+
+    /* samples are rare: one TSC read covers the batch */
+    if (now == 0)
+      now = rdtsc();
+    uint64_t ns = tsc_to_ns(now - ts);
+    SessionLatency &l = latency[ctr_id];
+
+    /* workers may sample the same session: relaxed atomics, as samples are
+     * rare and the buckets need not agree with each other */
+    __atomic_fetch_add(&l.latency[LatencyBucket(ns)], 1, __ATOMIC_RELAXED);
+    uint32_t last = __atomic_exchange_n(
+        &l.last_ns, ns < UINT32_MAX ? (ns ?: 1) : UINT32_MAX, __ATOMIC_RELAXED);
+    if (last != 0) {
+      uint64_t jitter = ns > last ? ns - last : last - ns;
+      __atomic_fetch_add(&l.jitter[LatencyBucket(jitter)], 1,
+                         __ATOMIC_RELAXED);
+    }
+  }
+}
+/*----------------------------------------------------------------------------------*/
 void Counter::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  uint64_t tsc = stats_.Begin();
   int cnt = batch->cnt();
 
   for (int i = 0; i < cnt; i++) {
@@ -110,9 +174,45 @@ void Counter::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
 #endif
   }
 
+  if (latency != nullptr)
+    RecordLatency(batch);
+
+  stats_.Gate(ctx->wid, 0, cnt);
+  stats_.End(ctx->wid, tsc, cnt);
   RunNextModule(ctx, batch);
 }
 /*----------------------------------------------------------------------------------*/
+static inline uint32_t ReadBucket(uint32_t *bucket, bool clear) {
+  return clear ? __atomic_exchange_n(bucket, 0, __ATOMIC_RELAXED)
+               : __atomic_load_n(bucket, __ATOMIC_RELAXED);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse Counter::GetLatency(
+    const bess::pb::CounterCommandGetLatencyArg &arg) {
+  bess::pb::CounterCommandGetLatencyResponse r;
+
+  if (latency == nullptr)
+    return CommandFailure(EINVAL, "Latency is not recorded");
+
+  r.set_num_buckets(kLatencyBuckets);
+  r.set_min_ns(kLatencyMinNs);
+  for (uint32_t ctr_id = 0; ctr_id < latency_count; ctr_id++) {
+    SessionLatency &l = latency[ctr_id];
+    if (__atomic_load_n(&l.last_ns, __ATOMIC_RELAXED) == 0)
+      continue;
+    r.add_ctr_ids(ctr_id);
+    /* read (and zero) each bucket at once, so no sample gets lost */
+    for (int i = 0; i < kLatencyBuckets; i++) {
+      r.add_latency(ReadBucket(&l.latency[i], arg.clear()));
+      r.add_jitter(ReadBucket(&l.jitter[i], arg.clear()));
+    }
+    if (arg.clear())
+      __atomic_store_n(&l.last_ns, 0, __ATOMIC_RELAXED);
+  }
+
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
 std::string Counter::GetDesc() const {
 #ifdef HASHMAP_BASED
   return bess::utils::Format("%zu sessions", (size_t)counters.size());
@@ -121,5 +221,17 @@ std::string Counter::GetDesc() const {
 #endif
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse Counter::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse Counter::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(Counter, "counter",
            "Counts the number of packets/bytes in the UP4 pipeline")
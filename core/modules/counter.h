@@ -7,6 +7,8 @@
 #define BESS_MODULES_COUNTER_H_
 
 #include "../module.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 #include <map>
 
 struct SessionStats {
@@ -14,6 +16,17 @@ struct SessionStats {
   uint64_t byte_count;
 };
 
+/* log2 buckets of ns, see CounterCommandGetLatencyResponse */
+static const int kLatencyBuckets = 16;
+static const uint32_t kLatencyMinNs = 256;
+
+/* shared by the workers, which update it with relaxed atomics */
+struct SessionLatency {
+  uint32_t latency[kLatencyBuckets];
+  uint32_t jitter[kLatencyBuckets];
+  uint32_t last_ns; /* latency of the previous sample, 0 if none */
+};
+
 class Counter final : public Module {
  public:
   Counter() : counters() { max_allowed_workers_ = Worker::kMaxWorkers; }
@@ -22,12 +35,20 @@ class Counter final : public Module {
   CommandResponse AddCounter(const bess::pb::CounterAddArg &arg);
   CommandResponse RemoveCounter(const bess::pb::CounterRemoveArg &arg);
   CommandResponse RemoveAllCounters(const bess::pb::EmptyArg &);
+  CommandResponse GetLatency(const bess::pb::CounterCommandGetLatencyArg &arg);
   CommandResponse Init(const bess::pb::CounterArg &arg);
+  void DeInit() override;
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
   // returns the number of active UE sessions
   std::string GetDesc() const override;
 
  private:
+  /* adds the latency of the sampled packets to their session's histograms */
+  void RecordLatency(bess::PacketBatch *batch);
+
 #ifdef HASHMAP_BASED
   std::map<uint32_t, SessionStats> counters;
 #else
@@ -38,6 +59,13 @@ class Counter final : public Module {
   bool check_exist;
   int ctr_attr_id;
   uint32_t total_count;
+  /* per ctr_id, if latency is recorded */
+  SessionLatency *latency = nullptr;
+  uint32_t latency_count = 0;
+  int ts_attr_id = -1;
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 
 #endif  // BESS_MODULES_COUNTER_H_
@@ -0,0 +1,76 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for ddn_notify decls */
+#include "ddn_notify.h"
+/* for current_worker */
+#include "../worker.h"
+/*----------------------------------------------------------------------------------*/
+/* default of DdnNotifyArg.holddown_ms */
+static const uint32_t kDefaultHolddownMs = 1000;
+
+enum { NOTIFY_GATE = 0, DROP_GATE };
+/*----------------------------------------------------------------------------------*/
+void DdnNotify::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+  uint64_t fseids[bess::PacketBatch::kMaxBurst];
+  int num_fseids = 0;
+  bess::Packet *msg = nullptr;
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    uint64_t fseid = get_attr<uint64_t>(this, fseid_attr_, p);
+
+    if (holddown_.Due(fseid, ctx->current_ns)) {
+      fseids[num_fseids++] = fseid;
+      /* the first one carries the notifications of the whole batch */
+      if (msg == nullptr) {
+        msg = p;
+        continue;
+      }
+    }
+    EmitPacket(ctx, p, DROP_GATE);
+  }
+  if (msg == nullptr)
+    return;
+
+  /* trimming fails on chained mbufs: write the message into a fresh one */
+  if (msg->trim(msg->total_len()) != 0) {
+    bess::Packet *fresh = current_worker.packet_pool()->Alloc();
+    EmitPacket(ctx, msg, DROP_GATE);
+    if (fresh == nullptr)
+      return;
+    msg = fresh;
+  }
+
+  size_t len = num_fseids * sizeof(uint64_t);
+  char *data = msg->append(len);
+  if (data == nullptr) {
+    EmitPacket(ctx, msg, DROP_GATE);
+    return;
+  }
+  memcpy(data, fseids, len);
+  EmitPacket(ctx, msg, NOTIFY_GATE);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse DdnNotify::Init(const bess::pb::DdnNotifyArg &arg) {
+  if (arg.max_sessions() == 0)
+    return CommandFailure(EINVAL, "Invalid max_sessions");
+  uint64_t holddown_ns =
+      (uint64_t)(arg.holddown_ms() ?: kDefaultHolddownMs) * 1000000;
+  if (!holddown_.Init(arg.max_sessions(), holddown_ns))
+    return CommandFailure(ENOMEM, "Unable to allocate the session table");
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  fseid_attr_ = AddMetadataAttr("fseid", sizeof(uint64_t), AccessMode::kRead);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void DdnNotify::DeInit() {
+  holddown_.Free();
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(DdnNotify, "ddn_notify",
+           "rate-limited downlink data notifications, batched per message")
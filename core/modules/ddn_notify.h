@@ -0,0 +1,40 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_DDNNOTIFY_H_
+#define BESS_MODULES_DDNNOTIFY_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for Holddown */
+#include "../utils/holddown.h"
+/*----------------------------------------------------------------------------------*/
+/**
+ * Turns the downlink packets of sessions whose FAR notifies the control plane
+ * into downlink data notifications, at most one per FSEID per holddown_ms.
+ * The FSEIDs left of a batch (host order, 8 bytes each) are written into one
+ * of its packets, which goes out as a single message through gate 0; the
+ * other packets leave through gate 1, for the pipeline to count as drops.
+ *
+ * Sessions are held down by a Holddown table sized after max_sessions,
+ * which workers share without locks.
+ */
+class DdnNotify final : public Module {
+ public:
+  DdnNotify() { max_allowed_workers_ = Worker::kMaxWorkers; }
+
+  /* Gates: (0) Notifications, (1) Held down */
+  static const gate_idx_t kNumOGates = 2;
+
+  CommandResponse Init(const bess::pb::DdnNotifyArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+
+ private:
+  bess::utils::Holddown holddown_;
+
+  int fseid_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_DDNNOTIFY_H_
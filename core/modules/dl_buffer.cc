@@ -0,0 +1,288 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for dl_buffer decls */
+#include "dl_buffer.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for rdtsc(), tsc_to_ns() */
+#include "utils/time.h"
+/* for rte_hash_crc_8byte() */
+#include <rte_hash_crc.h>
+/*----------------------------------------------------------------------------------*/
+/* defaults of the DlBufferArg fields */
+static const uint32_t kDefaultSessionPkts = 64;
+static const uint32_t kDefaultPkts = 8192;
+static const uint32_t kDefaultAgeMs = 2000;
+
+/* queues are aged this many times per max_age */
+static const uint64_t kAgeSteps = 8;
+
+/* how long after a flush packets still classified with the buffering FAR
+ * are released rather than queued; short, as the FAR forwards by then and
+ * a new buffering FAR would send them around again */
+static const uint64_t kLateNs = 10 * 1000000;
+
+enum { RELEASE_GATE = 0, OVERFLOW_GATE, AGED_GATE };
+
+const Commands DlBuffer::cmds = {{"flush", "DlBufferCommandFlushArg",
+                                  MODULE_CMD_FUNC(&DlBuffer::CommandFlush),
+                                  Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+void DlBuffer::Push(Queue *q, uint32_t slot) {
+  slots_[slot].next = kNone;
+  if (q->cnt == 0)
+    q->head = slot;
+  else
+    slots_[q->tail].next = slot;
+  q->tail = slot;
+  q->cnt++;
+}
+/*----------------------------------------------------------------------------------*/
+void DlBuffer::Splice(Queue *from, Queue *to) {
+  if (from->cnt == 0)
+    return;
+  if (to->cnt == 0)
+    to->head = from->head;
+  else
+    slots_[to->tail].next = from->head;
+  to->tail = from->tail;
+  to->cnt += from->cnt;
+  from->cnt = 0;
+}
+/*----------------------------------------------------------------------------------*/
+static inline uint32_t HashFseid(uint64_t fseid) {
+  return rte_hash_crc_8byte(fseid, 0);
+}
+/*----------------------------------------------------------------------------------*/
+DlBuffer::Session *DlBuffer::Find(uint64_t fseid) {
+  uint32_t i = HashFseid(fseid) & session_mask_;
+
+  for (; sessions_[i].used; i = (i + 1) & session_mask_) {
+    if (sessions_[i].fseid == fseid)
+      return &sessions_[i];
+  }
+  return nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+DlBuffer::Session *DlBuffer::Insert(uint64_t fseid) {
+  /* at most half full, for short probes */
+  if (num_sessions_ >= (session_mask_ + 1) / 2)
+    return nullptr;
+
+  uint32_t i = HashFseid(fseid) & session_mask_;
+  while (sessions_[i].used)
+    i = (i + 1) & session_mask_;
+  sessions_[i] = {fseid, {kNone, kNone, 0}, 0, true};
+  num_sessions_++;
+
+  return &sessions_[i];
+}
+/*----------------------------------------------------------------------------------*/
+DlBuffer::Session *DlBuffer::Erase(Session *s) {
+  uint32_t hole = s - sessions_.data();
+
+  /* shift back the sessions of the probe run that the hole would cut off */
+  for (uint32_t i = (hole + 1) & session_mask_; sessions_[i].used;
+       i = (i + 1) & session_mask_) {
+    uint32_t home = HashFseid(sessions_[i].fseid) & session_mask_;
+    if (((i - home) & session_mask_) >= ((i - hole) & session_mask_)) {
+      sessions_[hole] = sessions_[i];
+      hole = i;
+    }
+  }
+  sessions_[hole].used = false;
+  num_sessions_--;
+
+  return s->used ? s : nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+void DlBuffer::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+
+  rte_spinlock_lock(&lock_);
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    uint64_t fseid = get_attr<uint64_t>(this, fseid_attr_, p);
+    Session *s = Find(fseid);
+    bool late = s != nullptr && s->flushed_ns > ctx->current_ns;
+
+    if (free_ == kNone || (s == nullptr && (s = Insert(fseid)) == nullptr) ||
+        (!late && s->q.cnt >= max_session_pkts_)) {
+      num_dropped_++;
+      EmitPacket(ctx, p, OVERFLOW_GATE);
+      continue;
+    }
+    uint32_t slot = free_;
+    free_ = slots_[slot].next;
+    slots_[slot].ns = ctx->current_ns;
+    slots_[slot].pkt = p;
+    if (late) {
+      Push(&released_, slot);
+    } else {
+      Push(&s->q, slot);
+      num_pkts_++;
+    }
+  }
+  rte_spinlock_unlock(&lock_);
+}
+/*----------------------------------------------------------------------------------*/
+void DlBuffer::Age(Context *ctx) {
+  for (uint32_t i = 0; i <= session_mask_; i++) {
+    Session *s = &sessions_[i];
+
+    /* Erase() may shift another session in: look at this slot again */
+    while (s != nullptr && s->used) {
+      Queue *q = &s->q;
+      while (q->cnt > 0 &&
+             slots_[q->head].ns + max_age_ns_ <= ctx->current_ns) {
+        uint32_t slot = q->head;
+        q->head = slots_[slot].next;
+        q->cnt--;
+        num_dropped_++;
+        num_pkts_--;
+        EmitPacket(ctx, slots_[slot].pkt, AGED_GATE);
+        slots_[slot].next = free_;
+        free_ = slot;
+      }
+      if (q->cnt > 0 || s->flushed_ns > ctx->current_ns)
+        break;
+      s = Erase(s);
+    }
+  }
+}
+/*----------------------------------------------------------------------------------*/
+struct task_result DlBuffer::RunTask(Context *ctx, bess::PacketBatch *batch,
+                                     void *) {
+  uint64_t bits = 0;
+
+  batch->clear();
+  rte_spinlock_lock(&lock_);
+  while (released_.cnt > 0 &&
+         batch->cnt() < (int)bess::PacketBatch::kMaxBurst) {
+    uint32_t slot = released_.head;
+    bess::Packet *p = slots_[slot].pkt;
+    released_.head = slots_[slot].next;
+    released_.cnt--;
+    slots_[slot].next = free_;
+    free_ = slot;
+    bits += (p->total_len() + 24) * 8;
+    batch->add(p);
+  }
+  if (ctx->current_ns >= next_age_ns_) {
+    Age(ctx);
+    next_age_ns_ = ctx->current_ns + max_age_ns_ / kAgeSteps;
+  }
+  rte_spinlock_unlock(&lock_);
+
+  uint32_t cnt = batch->cnt();
+  if (cnt > 0)
+    RunNextModule(ctx, batch);
+
+  return {.block = cnt == 0, .packets = cnt, .bits = bits};
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse DlBuffer::CommandFlush(
+    const bess::pb::DlBufferCommandFlushArg &arg) {
+  std::vector<bess::Packet *> dropped;
+  uint64_t now = tsc_to_ns(rdtsc());
+
+  rte_spinlock_lock(&lock_);
+  for (uint64_t fseid : arg.fseids()) {
+    Session *s = Find(fseid);
+
+    if (arg.drop()) {
+      if (s == nullptr)
+        continue;
+      num_pkts_ -= s->q.cnt;
+      for (uint32_t slot = s->q.head; s->q.cnt > 0; s->q.cnt--) {
+        uint32_t next = slots_[slot].next;
+        dropped.push_back(slots_[slot].pkt);
+        slots_[slot].next = free_;
+        free_ = slot;
+        slot = next;
+      }
+      s->flushed_ns = 0;
+      continue;
+    }
+
+    /* release, and mark the session for the packets still on their way
+     * (unless the table is full: those will age out) */
+    if (s == nullptr && (s = Insert(fseid)) == nullptr)
+      continue;
+    num_pkts_ -= s->q.cnt;
+    Splice(&s->q, &released_);
+    s->flushed_ns = now + kLateNs;
+  }
+  num_dropped_ += dropped.size();
+  rte_spinlock_unlock(&lock_);
+
+  /* no Context to emit them with out here, and not a pipeline drop */
+  if (!dropped.empty())
+    bess::Packet::Free(dropped.data(), dropped.size());
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse DlBuffer::Init(const bess::pb::DlBufferArg &arg) {
+  max_session_pkts_ = arg.max_session_pkts() ?: kDefaultSessionPkts;
+  max_pkts_ = arg.max_pkts() ?: kDefaultPkts;
+  max_age_ns_ = (uint64_t)(arg.max_age_ms() ?: kDefaultAgeMs) * 1000000;
+  rte_spinlock_init(&lock_);
+
+  slots_.resize(max_pkts_);
+  for (uint32_t i = 0; i < max_pkts_; i++)
+    slots_[i].next = i + 1 < max_pkts_ ? i + 1 : kNone;
+  free_ = 0;
+  released_ = {kNone, kNone, 0};
+
+  /* a session per packet at most, in a table kept at most half full */
+  uint32_t size = 1;
+  while (size < 2 * max_pkts_)
+    size <<= 1;
+  sessions_.assign(size, Session());
+  session_mask_ = size - 1;
+  num_sessions_ = 0;
+
+  if (RegisterTask(nullptr) == INVALID_TASK_ID)
+    return CommandFailure(ENOMEM, "Task creation failed");
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  fseid_attr_ = AddMetadataAttr("fseid", sizeof(uint64_t), AccessMode::kRead);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void DlBuffer::DeInit() {
+  for (Session &s : sessions_) {
+    if (!s.used)
+      continue;
+    for (uint32_t slot = s.q.head; s.q.cnt > 0; s.q.cnt--) {
+      bess::Packet::Free(slots_[slot].pkt);
+      slot = slots_[slot].next;
+    }
+  }
+  for (uint32_t slot = released_.head; released_.cnt > 0; released_.cnt--) {
+    bess::Packet::Free(slots_[slot].pkt);
+    slot = slots_[slot].next;
+  }
+  sessions_.clear();
+  slots_.clear();
+  free_ = kNone;
+  num_sessions_ = 0;
+  num_pkts_ = 0;
+}
+/*----------------------------------------------------------------------------------*/
+std::string DlBuffer::GetDesc() const {
+  rte_spinlock_lock(&lock_);
+  std::string desc = bess::utils::Format(
+      "%zu sessions, %zu packets queued, %lu dropped", num_sessions_,
+      num_pkts_, num_dropped_);
+  rte_spinlock_unlock(&lock_);
+
+  return desc;
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(DlBuffer, "dl_buffer",
+           "queues the downlink packets of buffering FARs per session")
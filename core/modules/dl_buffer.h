@@ -0,0 +1,116 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_DLBUFFER_H_
+#define BESS_MODULES_DLBUFFER_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for rte_spinlock */
+#include <rte_spinlock.h>
+#include <vector>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Queues the downlink packets of sessions whose FAR buffers them (UEs being
+ * paged), per FSEID, until the control plane either releases them with
+ * `flush' (the FAR forwards again) or drops them (the session goes away).
+ * Released packets leave through gate 0, to be classified again with the
+ * new FAR. Queues are bounded per session and overall: packets that don't
+ * fit leave through gate 1, and packets older than max_age_ms through gate
+ * 2, for the pipeline to count as drops.
+ *
+ * Releasing and aging are done by the module's task, since commands can't
+ * emit packets: it hands out up to one batch of released packets per run.
+ * Packets of a released session that were classified before its FAR
+ * changed, and so arrive after the flush, join the released ones for a
+ * short while instead of waiting to age out.
+ *
+ * Everything is preallocated at Init: packets sit in a pool of max_pkts
+ * slots, linked into per-session queues, and sessions in an open-addressed
+ * table, so queueing under the lock never allocates.
+ */
+class DlBuffer final : public Module {
+ public:
+  DlBuffer()
+      : lock_(),
+        free_(kNone),
+        released_(),
+        session_mask_(),
+        num_sessions_(),
+        num_pkts_(),
+        num_dropped_() {
+    max_allowed_workers_ = Worker::kMaxWorkers;
+  }
+
+  static const gate_idx_t kNumOGates = 3;
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::DlBufferArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  struct task_result RunTask(Context *ctx, bess::PacketBatch *batch,
+                             void *arg) override;
+  // returns the number of sessions and packets queued
+  std::string GetDesc() const override;
+
+  CommandResponse CommandFlush(const bess::pb::DlBufferCommandFlushArg &arg);
+
+ private:
+  static const uint32_t kNone = UINT32_MAX;
+
+  /* a packet and when it was queued, linked into a queue or the free list */
+  struct Slot {
+    uint64_t ns;
+    bess::Packet *pkt;
+    uint32_t next;
+  };
+
+  /* slots from head to tail */
+  struct Queue {
+    uint32_t head;
+    uint32_t tail;
+    uint32_t cnt;
+  };
+
+  struct Session {
+    uint64_t fseid;
+    Queue q;
+    uint64_t flushed_ns; /* late packets are released until then */
+    bool used;
+  };
+
+  void Push(Queue *q, uint32_t slot);
+  /* moves the slots of `from' to the tail of `to' */
+  void Splice(Queue *from, Queue *to);
+
+  Session *Find(uint64_t fseid);
+  /* nullptr if the table is full */
+  Session *Insert(uint64_t fseid);
+  /* returns the session now in place of `s', if any */
+  Session *Erase(Session *s);
+
+  /* drops the packets queued for longer than max_age_ns_, and forgets the
+   * sessions with neither packets nor a flush pending */
+  void Age(Context *ctx);
+
+  /* workers queue, the task releases and ages, commands flush */
+  mutable rte_spinlock_t lock_;
+  std::vector<Slot> slots_;
+  uint32_t free_;
+  Queue released_;
+  std::vector<Session> sessions_;
+  uint32_t session_mask_;
+  size_t num_sessions_;
+  size_t num_pkts_; /* queued, released ones aside */
+  uint64_t num_dropped_;
+
+  uint32_t max_session_pkts_ = 0;
+  uint32_t max_pkts_ = 0;
+  uint64_t max_age_ns_ = 0;
+  uint64_t next_age_ns_ = 0;
+
+  int fseid_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_DLBUFFER_H_
@@ -0,0 +1,131 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for drop_counter decls */
+#include "drop_counter.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/*----------------------------------------------------------------------------------*/
+const Commands DropCounter::cmds = {{"get", "DropCounterCommandGetArg",
+                                     MODULE_CMD_FUNC(&DropCounter::CommandGet),
+                                     Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+void DropCounter::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  gate_idx_t reason = ctx->current_igate;
+  int cnt = batch->cnt();
+
+  drops_[ctx->wid].packets[reason] += cnt;
+
+  int col = session_col_[reason];
+  if (col >= 0) {
+    size_t ncols = session_reasons_.size();
+    for (int i = 0; i < cnt; i++) {
+      uint32_t ctr_id =
+          get_attr<uint32_t>(this, ctr_attr_id_, batch->pkts()[i]);
+      if (ctr_id < max_sessions_)
+        session_drops_[ctr_id * ncols + col]++;
+    }
+  }
+
+  bess::Packet::Free(batch->pkts(), cnt);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse DropCounter::CommandGet(
+    const bess::pb::DropCounterCommandGetArg &arg) {
+  bess::pb::DropCounterCommandGetResponse r;
+  size_t ncols = session_reasons_.size();
+
+  for (size_t reason = 0; reason < reasons_.size(); reason++) {
+    uint64_t packets = 0;
+    for (int wid = 0; wid < Worker::kMaxWorkers; wid++) {
+      packets += drops_[wid].packets[reason];
+      if (arg.clear())
+        drops_[wid].packets[reason] = 0;
+    }
+    r.add_reasons(reasons_[reason]);
+    r.add_packets(packets);
+  }
+
+  for (gate_idx_t reason : session_reasons_)
+    r.add_session_reasons(reasons_[reason]);
+
+  /* only the sessions with drops, to keep the response small */
+  for (uint32_t ctr_id = 0; ctr_id < max_sessions_; ctr_id++) {
+    uint64_t *row = &session_drops_[ctr_id * ncols];
+    bool any = false;
+    for (size_t col = 0; col < ncols; col++)
+      any |= row[col] != 0;
+    if (!any)
+      continue;
+    r.add_ctr_ids(ctr_id);
+    for (size_t col = 0; col < ncols; col++) {
+      r.add_session_packets(row[col]);
+      if (arg.clear())
+        row[col] = 0;
+    }
+  }
+
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse DropCounter::Init(const bess::pb::DropCounterArg &arg) {
+  if (arg.reasons_size() == 0 || arg.reasons_size() > kNumIGates)
+    return CommandFailure(EINVAL, "Between 1 and %d reasons are needed",
+                          kNumIGates);
+
+  reasons_.assign(arg.reasons().begin(), arg.reasons().end());
+  for (gate_idx_t reason = 0; reason < kNumIGates; reason++)
+    session_col_[reason] = -1;
+
+  for (const std::string &name : arg.session_reasons()) {
+    gate_idx_t reason = 0;
+    while (reason < reasons_.size() && reasons_[reason] != name)
+      reason++;
+    if (reason == reasons_.size())
+      return CommandFailure(EINVAL, "Unknown session reason '%s'",
+                            name.c_str());
+    if (session_col_[reason] >= 0)
+      continue;
+    session_col_[reason] = session_reasons_.size();
+    session_reasons_.push_back(reason);
+  }
+
+  if (!session_reasons_.empty()) {
+    max_sessions_ = arg.max_sessions();
+    if (max_sessions_ == 0)
+      return CommandFailure(EINVAL,
+                            "max_sessions is needed for session reasons");
+    session_drops_ = (uint64_t *)calloc((size_t)max_sessions_ *
+                                            session_reasons_.size(),
+                                        sizeof(uint64_t));
+    if (session_drops_ == nullptr)
+      return CommandFailure(ENOMEM, "Unable to allocate session counters");
+
+    using AccessMode = bess::metadata::Attribute::AccessMode;
+    ctr_attr_id_ =
+        AddMetadataAttr("ctr_id", sizeof(uint32_t), AccessMode::kRead);
+  }
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void DropCounter::DeInit() {
+  free(session_drops_);
+  session_drops_ = nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+std::string DropCounter::GetDesc() const {
+  uint64_t packets = 0;
+
+  for (size_t reason = 0; reason < reasons_.size(); reason++) {
+    for (int wid = 0; wid < Worker::kMaxWorkers; wid++)
+      packets += drops_[wid].packets[reason];
+  }
+
+  return bess::utils::Format("%zu reasons, %lu dropped", reasons_.size(),
+                             packets);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(DropCounter, "drop_counter",
+           "counts dropped packets per reason and per session")
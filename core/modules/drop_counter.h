@@ -0,0 +1,57 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_DROPCOUNTER_H_
+#define BESS_MODULES_DROPCOUNTER_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+#include <string>
+#include <vector>
+/*----------------------------------------------------------------------------------*/
+/**
+ * The one place the pipeline drops packets: each input gate is a drop
+ * reason, named by `reasons'. Packets are counted per reason and worker,
+ * without locks, and freed. For the reasons listed in `session_reasons'
+ * (drops after the PDR lookup, whose packets carry a ctr_id) they are also
+ * counted per ctr_id below max_sessions; those counters are shared by the
+ * workers and, like Counter's, may lose an increment under contention.
+ *
+ * `get' returns all of them in one response.
+ */
+class DropCounter final : public Module {
+ public:
+  static const gate_idx_t kNumIGates = 64;
+  static const gate_idx_t kNumOGates = 0;
+
+  DropCounter() { max_allowed_workers_ = Worker::kMaxWorkers; }
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::DropCounterArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns the total number of packets dropped
+  std::string GetDesc() const override;
+
+  CommandResponse CommandGet(const bess::pb::DropCounterCommandGetArg &arg);
+
+ private:
+  struct alignas(64) WorkerDrops {
+    uint64_t packets[kNumIGates];
+  };
+
+  std::vector<std::string> reasons_;
+  WorkerDrops drops_[Worker::kMaxWorkers] = {};
+
+  /* per reason, its column in session_drops_ or -1 */
+  int session_col_[kNumIGates];
+  std::vector<gate_idx_t> session_reasons_;
+  /* max_sessions_ rows of session_reasons_.size() counters */
+  uint64_t *session_drops_ = nullptr;
+  uint32_t max_sessions_ = 0;
+
+  int ctr_attr_id_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_DROPCOUNTER_H_
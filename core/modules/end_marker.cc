@@ -0,0 +1,157 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for end_marker decls */
+#include "end_marker.h"
+/* for IPVERSION */
+#include <netinet/ip.h>
+/* for CalculateIpv4Checksum() */
+#include "utils/checksum.h"
+/* for ethernet header */
+#include "utils/ether.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for gtp header */
+#include "utils/gtp.h"
+/* for ip header */
+#include "utils/ip.h"
+/* for udp header */
+#include "utils/udp.h"
+/*----------------------------------------------------------------------------------*/
+using bess::utils::be16_t;
+using bess::utils::be32_t;
+using bess::utils::CalculateIpv4Checksum;
+using bess::utils::CalculateIpv4UdpChecksum;
+using bess::utils::Ethernet;
+using bess::utils::Gtpv1;
+using bess::utils::Ipv4;
+using bess::utils::Udp;
+
+static const uint16_t kGtpuPort = 2152;
+static const uint8_t kGtpEndMarker = 254;
+
+/* bytes of a tunnel in EndMarkerCommandSendArg.tunnels */
+static const size_t kTunnelSize = 12;
+
+const Commands EndMarker::cmds = {{"send", "EndMarkerCommandSendArg",
+                                   MODULE_CMD_FUNC(&EndMarker::CommandSend),
+                                   Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+// Template of an end marker, the tunnel left to fill in
+struct [[gnu::packed]] EndMarkerTemplate {
+  Ethernet eth;
+  Ipv4 iph;
+  Udp udph;
+  Gtpv1 gtph;
+
+  EndMarkerTemplate() {
+    memset(&eth, 0, sizeof(eth));
+    eth.ether_type = (be16_t)(Ethernet::kIpv4);
+    iph.version = IPVERSION;
+    iph.header_length = (sizeof(Ipv4) >> 2);
+    iph.type_of_service = 0;
+    iph.length = (be16_t)(sizeof(Ipv4) + sizeof(Udp) + sizeof(Gtpv1));
+    iph.id = (be16_t)0;
+    iph.fragment_offset = (be16_t)0;
+    iph.ttl = 64;
+    iph.protocol = IPPROTO_UDP;
+    iph.checksum = 0;
+    iph.src = (be32_t)0;  // to fill in
+    iph.dst = (be32_t)0;  // to fill in
+    udph.src_port = (be16_t)kGtpuPort;
+    udph.dst_port = (be16_t)kGtpuPort;
+    udph.length = (be16_t)(sizeof(Udp) + sizeof(Gtpv1));
+    udph.checksum = 0;
+    gtph.version = 1;
+    gtph.pt = 1;
+    gtph.spare = 0;
+    gtph.ex = 0;
+    gtph.seq = 0;
+    gtph.pdn = 0;
+    gtph.type = kGtpEndMarker;
+    gtph.length = (be16_t)0;
+    gtph.teid = (be32_t)0;  // to fill in
+  }
+};
+static const EndMarkerTemplate end_marker_template;
+/*----------------------------------------------------------------------------------*/
+struct task_result EndMarker::RunTask(Context *ctx, bess::PacketBatch *batch,
+                                      void *) {
+  Tunnel tunnels[bess::PacketBatch::kMaxBurst];
+  size_t cnt = 0;
+
+  rte_spinlock_lock(&lock_);
+  while (cnt < bess::PacketBatch::kMaxBurst && !pending_.empty()) {
+    tunnels[cnt++] = pending_.front();
+    pending_.pop_front();
+  }
+  rte_spinlock_unlock(&lock_);
+
+  if (cnt == 0)
+    return {.block = true, .packets = 0, .bits = 0};
+
+  if (!current_worker.packet_pool()->AllocBulk(batch->pkts(), cnt,
+                                               sizeof(EndMarkerTemplate))) {
+    /* try again next time, in the same order */
+    rte_spinlock_lock(&lock_);
+    pending_.insert(pending_.begin(), tunnels, tunnels + cnt);
+    rte_spinlock_unlock(&lock_);
+    return {.block = true, .packets = 0, .bits = 0};
+  }
+  batch->set_cnt(cnt);
+
+  for (size_t i = 0; i < cnt; i++) {
+    EndMarkerTemplate *m =
+        batch->pkts()[i]->head_data<EndMarkerTemplate *>();
+
+    *m = end_marker_template;
+    m->iph.src = tunnels[i].src;
+    m->iph.dst = tunnels[i].dst;
+    m->gtph.teid = tunnels[i].teid;
+    m->iph.checksum = CalculateIpv4Checksum(m->iph);
+    m->udph.checksum = CalculateIpv4UdpChecksum(m->iph, m->udph);
+  }
+  RunNextModule(ctx, batch);
+
+  return {.block = false,
+          .packets = (uint32_t)cnt,
+          .bits = (sizeof(EndMarkerTemplate) + 24) * 8 * cnt};
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse EndMarker::CommandSend(
+    const bess::pb::EndMarkerCommandSendArg &arg) {
+  const std::string &tunnels = arg.tunnels();
+
+  if (tunnels.size() % kTunnelSize != 0)
+    return CommandFailure(EINVAL, "tunnels must be %zu bytes each",
+                          kTunnelSize);
+
+  rte_spinlock_lock(&lock_);
+  for (size_t off = 0; off < tunnels.size(); off += kTunnelSize) {
+    Tunnel t;
+    memcpy(&t, tunnels.data() + off, kTunnelSize);
+    pending_.push_back(t);
+  }
+  rte_spinlock_unlock(&lock_);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse EndMarker::Init(const bess::pb::EmptyArg &) {
+  rte_spinlock_init(&lock_);
+  if (RegisterTask(nullptr) == INVALID_TASK_ID)
+    return CommandFailure(ENOMEM, "Task creation failed");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+std::string EndMarker::GetDesc() const {
+  rte_spinlock_lock(&lock_);
+  size_t pending = pending_.size();
+  rte_spinlock_unlock(&lock_);
+
+  return bess::utils::Format("%zu pending", pending);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(EndMarker, "end_marker", "builds GTP-U end markers for tunnels")
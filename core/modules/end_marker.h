@@ -0,0 +1,50 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_ENDMARKER_H_
+#define BESS_MODULES_ENDMARKER_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for be32_t */
+#include "../utils/endian.h"
+/* for rte_spinlock */
+#include <rte_spinlock.h>
+#include <deque>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Builds GTP-U end marker packets (message type 254) for the tunnels given
+ * to its `send' command and emits them from its task, at most a batch per
+ * run. The packets carry no MAC addresses: they are meant for the access
+ * route, which sets those.
+ */
+class EndMarker final : public Module {
+ public:
+  EndMarker() : lock_() {}
+
+  static const gate_idx_t kNumIGates = 0;
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::EmptyArg &arg);
+  struct task_result RunTask(Context *ctx, bess::PacketBatch *batch,
+                             void *arg) override;
+  // returns the number of end markers waiting to be sent
+  std::string GetDesc() const override;
+
+  CommandResponse CommandSend(const bess::pb::EndMarkerCommandSendArg &arg);
+
+ private:
+  /* network order */
+  struct Tunnel {
+    bess::utils::be32_t src;
+    bess::utils::be32_t dst;
+    bess::utils::be32_t teid;
+  };
+
+  /* the command queues, the task sends */
+  mutable rte_spinlock_t lock_;
+  std::deque<Tunnel> pending_;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_ENDMARKER_H_
@@ -27,7 +27,14 @@ using bess::utils::Gtpv1;
 using bess::utils::Ipv4;
 using bess::utils::Udp;
 /*----------------------------------------------------------------------------------*/
+const Commands GtpuDecap::cmds = {
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&GtpuDecap::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&GtpuDecap::CommandSetStats), Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
 void GtpuDecap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  uint64_t tsc = stats_.Begin();
   int cnt = batch->cnt();
 
   for (int i = 0; i < cnt; i++) {
@@ -45,7 +52,21 @@ void GtpuDecap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
     memcpy(new_p, eth, sizeof(*eth));
   }
 
+  stats_.Gate(ctx->wid, 0, cnt);
+  stats_.End(ctx->wid, tsc, cnt);
   RunNextModule(ctx, batch);
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse GtpuDecap::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse GtpuDecap::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(GtpuDecap, "gtpu_decap", "first version of gtpu decap module")
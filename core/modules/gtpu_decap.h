@@ -8,13 +8,24 @@
 #include "../module.h"
 #include "../pb/module_msg.pb.h"
 #include "../utils/gtp_common.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 #include <rte_hash.h>
 /*----------------------------------------------------------------------------------*/
 class GtpuDecap final : public Module {
  public:
   GtpuDecap() { max_allowed_workers_ = Worker::kMaxWorkers; }
 
+  static const Commands cmds;
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
+
+ private:
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 /*----------------------------------------------------------------------------------*/
 #endif  // BESS_MODULES_GTPUDECAP_H_
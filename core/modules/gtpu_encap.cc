@@ -34,6 +34,12 @@ using bess::utils::Udp;
 
 enum { DEFAULT_GATE = 0, FORWARD_GATE };
 /*----------------------------------------------------------------------------------*/
+const Commands GtpuEncap::cmds = {
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&GtpuEncap::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&GtpuEncap::CommandSetStats), Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
 // Template for generating UDP packets without data
 struct [[gnu::packed]] PacketTemplate {
   Ipv4 iph;
@@ -82,6 +88,7 @@ struct [[gnu::packed]] PacketTemplate {
 static PacketTemplate outer_ip_template;
 /*----------------------------------------------------------------------------------*/
 void GtpuEncap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  uint64_t tsc = stats_.Begin();
   int cnt = batch->cnt();
 
   for (int i = 0; i < cnt; i++) {
@@ -128,6 +135,7 @@ void GtpuEncap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
     if (new_p == NULL) {
       /* failed to prepend header space for encaped packet */
       EmitPacket(ctx, p, DEFAULT_GATE);
+      stats_.Gate(ctx->wid, DEFAULT_GATE);
       DLOG(INFO) << "prepend() failed!" << std::endl;
       continue;
     }
@@ -175,7 +183,9 @@ void GtpuEncap::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
     iph->dst = (be32_t)(at_tout_dip);
 
     EmitPacket(ctx, p, FORWARD_GATE);
+    stats_.Gate(ctx->wid, FORWARD_GATE);
   }
+  stats_.End(ctx->wid, tsc, cnt);
 }
 /*----------------------------------------------------------------------------------*/
 CommandResponse GtpuEncap::Init(const bess::pb::GtpuEncapArg &arg) {
@@ -208,4 +218,16 @@ CommandResponse GtpuEncap::Init(const bess::pb::GtpuEncapArg &arg) {
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse GtpuEncap::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse GtpuEncap::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(GtpuEncap, "gtpu_encap", "first version of gtpu encap module")
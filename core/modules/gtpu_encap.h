@@ -8,6 +8,8 @@
 #include "../module.h"
 #include "../pb/module_msg.pb.h"
 #include "../utils/gtp_common.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 #include <rte_hash.h>
 /*----------------------------------------------------------------------------------*/
 /**
@@ -28,8 +30,12 @@ class GtpuEncap final : public Module {
 
   /* Gates: (0) Default, (1) Forward */
   static const gate_idx_t kNumOGates = 2;
+  static const Commands cmds;
 
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
   CommandResponse Init(const bess::pb::GtpuEncapArg &arg);
 
  private:
@@ -41,6 +47,9 @@ class GtpuEncap final : public Module {
   int tout_dip_attr = -1;
   int tout_teid = -1;
   int tout_uport = -1;
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 /*----------------------------------------------------------------------------------*/
 #endif  // BESS_MODULES_GTPUENCAP_H_
@@ -0,0 +1,227 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for gtpu_error_ind decls */
+#include "gtpu_error_ind.h"
+/* for IPVERSION */
+#include <netinet/ip.h>
+/* for CalculateIpv4Checksum() */
+#include "utils/checksum.h"
+/* for ethernet header */
+#include "utils/ether.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for gtp header */
+#include "utils/gtp.h"
+/* for ip header */
+#include "utils/ip.h"
+/* for udp header */
+#include "utils/udp.h"
+/* for current_worker */
+#include "../worker.h"
+/*----------------------------------------------------------------------------------*/
+using bess::utils::be16_t;
+using bess::utils::be32_t;
+using bess::utils::CalculateIpv4Checksum;
+using bess::utils::CalculateIpv4UdpChecksum;
+using bess::utils::Ethernet;
+using bess::utils::Gtpv1;
+using bess::utils::Gtpv1SeqPDUExt;
+using bess::utils::Ipv4;
+using bess::utils::Udp;
+
+/* defaults of the GtpuErrorIndArg fields */
+static const uint32_t kDefaultPeers = 65536;
+static const uint32_t kDefaultHolddownMs = 1000;
+static const uint32_t kDefaultMaxPps = 1000;
+
+/* messages the global limit lets through back to back */
+static const uint64_t kBurst = bess::PacketBatch::kMaxBurst;
+
+static const uint16_t kGtpuPort = 2152;
+static const uint8_t kGtpErrorIndication = 26;
+static const uint8_t kGtpGPdu = 255;
+static const uint8_t kIeTeidDataI = 16;
+static const uint8_t kIePeerAddress = 133;
+
+/* src_iface values, as set by the pipeline */
+enum { kAccess = 1, kCore = 2 };
+enum { ACCESS_GATE = 0, CORE_GATE, DROP_GATE };
+/*----------------------------------------------------------------------------------*/
+// Template of an error indication, the tunnel left to fill in
+struct [[gnu::packed]] ErrorIndTemplate {
+  Ethernet eth;
+  Ipv4 iph;
+  Udp udph;
+  Gtpv1 gtph;
+  Gtpv1SeqPDUExt seqh;
+  /* Tunnel Endpoint Identifier Data I */
+  uint8_t teid_type;
+  be32_t teid;
+  /* GTP-U Peer Address */
+  uint8_t addr_type;
+  be16_t addr_len;
+  be32_t addr;
+
+  ErrorIndTemplate() {
+    memset(&eth, 0, sizeof(eth));
+    eth.ether_type = (be16_t)(Ethernet::kIpv4);
+    iph.version = IPVERSION;
+    iph.header_length = (sizeof(Ipv4) >> 2);
+    iph.type_of_service = 0;
+    iph.length = (be16_t)(sizeof(*this) - sizeof(Ethernet));
+    iph.id = (be16_t)0;
+    iph.fragment_offset = (be16_t)0;
+    iph.ttl = 64;
+    iph.protocol = IPPROTO_UDP;
+    iph.checksum = 0;
+    iph.src = (be32_t)0;  // to fill in
+    iph.dst = (be32_t)0;  // to fill in
+    udph.src_port = (be16_t)kGtpuPort;
+    udph.dst_port = (be16_t)kGtpuPort;
+    udph.length = (be16_t)(sizeof(*this) - sizeof(Ethernet) - sizeof(Ipv4));
+    udph.checksum = 0;
+    gtph.version = 1;
+    gtph.pt = 1;
+    gtph.spare = 0;
+    gtph.ex = 0;
+    gtph.seq = 1;
+    gtph.pdn = 0;
+    gtph.type = kGtpErrorIndication;
+    gtph.length = (be16_t)(sizeof(*this) - offsetof(ErrorIndTemplate, seqh));
+    gtph.teid = (be32_t)0;
+    seqh.seqnum = (be16_t)0;
+    seqh.npdu = 0;
+    seqh.ext = 0;
+    teid_type = kIeTeidDataI;
+    teid = (be32_t)0;  // to fill in
+    addr_type = kIePeerAddress;
+    addr_len = (be16_t)sizeof(addr);
+    addr = (be32_t)0;  // to fill in
+  }
+};
+static const ErrorIndTemplate error_ind_template;
+/*----------------------------------------------------------------------------------*/
+bool GtpuErrorInd::Allowed(uint64_t now) {
+  uint64_t old = __atomic_load_n(&tat_, __ATOMIC_RELAXED);
+
+  do {
+    uint64_t tat = std::max(old, now);
+    if (tat > now + burst_ns_)
+      return false;
+    /* on failure `old' is reloaded, and the rate checked again */
+    if (__atomic_compare_exchange_n(&tat_, &old, tat + interval_ns_, true,
+                                    __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+      return true;
+  } while (true);
+}
+/*----------------------------------------------------------------------------------*/
+void GtpuErrorInd::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  /* unanswered packets leave by the cause they came in with */
+  gate_idx_t drop_gate = DROP_GATE + ctx->current_igate;
+  int cnt = batch->cnt();
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    uint8_t iface = get_attr<uint8_t>(this, src_iface_attr_, p);
+    Ethernet *eth = p->head_data<Ethernet *>();
+    Ipv4 *iph = (Ipv4 *)(eth + 1);
+
+    if ((iface != kAccess && iface != kCore) ||
+        (size_t)p->head_len() < sizeof(Ethernet) + sizeof(Ipv4) ||
+        eth->ether_type != be16_t(Ethernet::kIpv4) ||
+        iph->protocol != IPPROTO_UDP) {
+      EmitPacket(ctx, p, drop_gate);
+      continue;
+    }
+    size_t ihl = iph->header_length << 2;
+    Udp *udph = (Udp *)((uint8_t *)iph + ihl);
+    Gtpv1 *gtph = (Gtpv1 *)(udph + 1);
+    if ((size_t)p->head_len() <
+            sizeof(Ethernet) + ihl + sizeof(Udp) + sizeof(Gtpv1) ||
+        udph->dst_port != be16_t(kGtpuPort) || gtph->version != 1 ||
+        gtph->type != kGtpGPdu) {
+      EmitPacket(ctx, p, drop_gate);
+      continue;
+    }
+
+    be32_t peer = iph->src;
+    be32_t self = iph->dst;
+    be32_t teid = gtph->teid;
+    uint64_t key = (uint64_t)peer.raw_value() << 32 | teid.raw_value();
+    if (holddown_.Held(key, ctx->current_ns)) {
+      EmitPacket(ctx, p, drop_gate);
+      continue;
+    }
+    /* only held down once answered, a limited one is answered next time */
+    if (!Allowed(ctx->current_ns)) {
+      counts_[ctx->wid].limited++;
+      EmitPacket(ctx, p, drop_gate);
+      continue;
+    }
+    holddown_.Due(key, ctx->current_ns);
+    counts_[ctx->wid].sent++;
+
+    /* trimming fails on chained mbufs: build the reply in a fresh one */
+    if (p->trim(p->total_len()) != 0) {
+      bess::Packet *fresh = current_worker.packet_pool()->Alloc();
+      if (fresh == nullptr) {
+        EmitPacket(ctx, p, drop_gate);
+        continue;
+      }
+      bess::Packet::Free(p);
+      p = fresh;
+    }
+    ErrorIndTemplate *m =
+        reinterpret_cast<ErrorIndTemplate *>(p->append(sizeof(*m)));
+    if (m == nullptr) {
+      EmitPacket(ctx, p, drop_gate);
+      continue;
+    }
+    *m = error_ind_template;
+    m->iph.src = self;
+    m->iph.dst = peer;
+    m->teid = teid;
+    m->addr = self;
+    m->iph.checksum = CalculateIpv4Checksum(m->iph);
+    m->udph.checksum = CalculateIpv4UdpChecksum(m->iph, m->udph);
+
+    EmitPacket(ctx, p, iface == kAccess ? ACCESS_GATE : CORE_GATE);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse GtpuErrorInd::Init(const bess::pb::GtpuErrorIndArg &arg) {
+  uint64_t holddown_ns =
+      (uint64_t)(arg.holddown_ms() ?: kDefaultHolddownMs) * 1000000;
+  if (!holddown_.Init(arg.max_peers() ?: kDefaultPeers, holddown_ns))
+    return CommandFailure(ENOMEM, "Unable to allocate the peer table");
+
+  interval_ns_ = 1000000000ull / (arg.max_pps() ?: kDefaultMaxPps);
+  burst_ns_ = interval_ns_ * (kBurst - 1);
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  src_iface_attr_ =
+      AddMetadataAttr("src_iface", sizeof(uint8_t), AccessMode::kRead);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void GtpuErrorInd::DeInit() {
+  holddown_.Free();
+}
+/*----------------------------------------------------------------------------------*/
+std::string GtpuErrorInd::GetDesc() const {
+  uint64_t sent = 0;
+  uint64_t limited = 0;
+
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++) {
+    sent += counts_[wid].sent;
+    limited += counts_[wid].limited;
+  }
+
+  return bess::utils::Format("%lu sent, %lu rate limited", sent, limited);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(GtpuErrorInd, "gtpu_error_ind",
+           "answers G-PDUs of unknown TEIDs with rate-limited error indications")
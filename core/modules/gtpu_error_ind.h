@@ -0,0 +1,65 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_GTPUERRORIND_H_
+#define BESS_MODULES_GTPUERRORIND_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for Holddown */
+#include "../utils/holddown.h"
+/*----------------------------------------------------------------------------------*/
+/**
+ * Answers the G-PDUs that matched no PDR (unknown TEID) with a GTP-U Error
+ * Indication (message type 26, TS 29.281 7.3.1) carrying their TEID and our
+ * own address, so that the peer tears the stale tunnel down. The packet is
+ * rewritten in place and leaves through gate 0 if it came from the access
+ * side, gate 1 if from the core side, to be routed back to its sender.
+ *
+ * Packets missed by the PDR lookup come in on gate 0, those of the session
+ * filter on gate 1. Those left unanswered (not G-PDUs, held down, rate
+ * limited) leave through gate 2 or 3 respectively, so that they are still
+ * counted as the drops they are.
+ *
+ * So that a flood can't be amplified, each (peer, TEID) is answered at most
+ * once per holddown_ms, and all peers together at most max_pps times per
+ * second. The global rate is shared by the workers without locks: once it
+ * is exceeded, refusing a packet takes a single load.
+ */
+class GtpuErrorInd final : public Module {
+ public:
+  GtpuErrorInd() : tat_(), counts_() {
+    max_allowed_workers_ = Worker::kMaxWorkers;
+  }
+
+  static const gate_idx_t kNumIGates = 2;
+  static const gate_idx_t kNumOGates = 4;
+
+  CommandResponse Init(const bess::pb::GtpuErrorIndArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns the number of error indications sent and rate limited
+  std::string GetDesc() const override;
+
+ private:
+  /* true if the global rate allows one more message at `now' */
+  bool Allowed(uint64_t now);
+
+  bess::utils::Holddown holddown_;
+
+  struct alignas(64) WorkerCounts {
+    uint64_t sent;
+    uint64_t limited;
+  };
+
+  /* generic cell rate algorithm over all workers, updated with CAS */
+  alignas(64) uint64_t tat_; /* theoretical arrival time */
+  uint64_t interval_ns_ = 0;
+  uint64_t burst_ns_ = 0;
+  WorkerCounts counts_[Worker::kMaxWorkers];
+
+  int src_iface_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_GTPUERRORIND_H_
@@ -0,0 +1,188 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for gtpu_gso decls */
+#include "gtpu_gso.h"
+/* for rte_pktmbuf_read() */
+#include <rte_mbuf.h>
+/* for be32_t */
+#include "utils/endian.h"
+/* for ip header */
+#include "utils/ip.h"
+/* for udp header */
+#include "utils/udp.h"
+/* for tcp header */
+#include "utils/tcp.h"
+/* for ethernet header */
+#include "utils/ether.h"
+/* for gtp header */
+#include "utils/gtp.h"
+/* for bess::utils::Copy() */
+#include "utils/copy.h"
+/* for CalculateIpv4Checksum() */
+#include "utils/checksum.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for current_worker */
+#include "../worker.h"
+/*----------------------------------------------------------------------------------*/
+using bess::utils::be16_t;
+using bess::utils::be32_t;
+using bess::utils::CalculateIpv4Checksum;
+using bess::utils::CalculateIpv4TcpChecksum;
+using bess::utils::Ethernet;
+using bess::utils::Gtpv1;
+using bess::utils::Ipv4;
+using bess::utils::Tcp;
+using bess::utils::Udp;
+
+enum { FORWARD_GATE = 0 };
+
+#define IP_FRAG_OFFSET_MASK 0x1FFF
+#define IP_MF_FLAG 0x2000
+#define TCP_FLAG_CWR 0x80
+/*----------------------------------------------------------------------------------*/
+/**
+ * Splits a GTP-U encapsulated TCP super-packet into MSS-sized segments.
+ * Each segment gets a copy of the outer (Eth/IP/UDP/GTP-U) and inner
+ * (IP/TCP) headers with the lengths, IP ids and TCP sequence numbers
+ * adjusted. Outer IP/UDP checksums are left to the modules downstream.
+ * Returns false if the packet does not need (or cannot go through)
+ * segmentation, in which case the caller still owns it.
+ */
+bool GtpuGso::SegmentPkt(Context *ctx, bess::Packet *p) {
+  uint32_t max_len = eth_mtu - RTE_ETHER_CRC_LEN;
+  uint32_t total_len = p->total_len();
+
+  if (likely(total_len <= max_len))
+    return false;
+
+  Ethernet *eth = p->head_data<Ethernet *>();
+  uint8_t *head_end = (uint8_t *)eth + p->head_len();
+  if (eth->ether_type != (be16_t)(Ethernet::kIpv4))
+    return false;
+
+  Ipv4 *oiph = (Ipv4 *)(eth + 1);
+  if (oiph->protocol != Ipv4::kUdp)
+    return false;
+
+  Udp *udph = (Udp *)((uint8_t *)oiph + (oiph->header_length << 2));
+  Gtpv1 *gtph = (Gtpv1 *)(udph + 1);
+  if ((uint8_t *)(gtph + 1) > head_end)
+    return false;
+
+  Ipv4 *iiph = (Ipv4 *)((uint8_t *)gtph + gtph->header_length());
+  if ((uint8_t *)(iiph + 1) > head_end || iiph->protocol != Ipv4::kTcp ||
+      (iiph->fragment_offset.value() & (IP_FRAG_OFFSET_MASK | IP_MF_FLAG)))
+    return false;
+
+  Tcp *tcph = (Tcp *)((uint8_t *)iiph + (iiph->header_length << 2));
+  if ((uint8_t *)(tcph + 1) > head_end)
+    return false;
+
+  /* all headers need to be in the first segment of the super-packet */
+  uint32_t hdrs_len = (uint8_t *)tcph + (tcph->offset << 2) - (uint8_t *)eth;
+  if ((uint8_t *)eth + hdrs_len > head_end || hdrs_len >= max_len ||
+      (uint8_t *)iiph - (uint8_t *)eth + iiph->length.value() != total_len)
+    return false;
+
+  uint32_t mss = max_len - hdrs_len;
+  uint32_t payload_len = total_len - hdrs_len;
+  uint32_t nsegs = (payload_len + mss - 1) / mss;
+  if (nsegs > GSO_MAX_SEGS)
+    return false;
+
+  bess::Packet *segs[GSO_MAX_SEGS];
+  if (!current_worker.packet_pool()->AllocBulk(segs, nsegs, 0))
+    return false;
+
+  uint32_t outer_off = (uint8_t *)udph - (uint8_t *)eth;
+  uint32_t gtp_off = (uint8_t *)gtph - (uint8_t *)eth;
+  uint32_t inner_off = (uint8_t *)iiph - (uint8_t *)eth;
+  uint32_t tcp_off = (uint8_t *)tcph - (uint8_t *)eth;
+  uint16_t ip_id = iiph->id.value();
+  uint32_t seq = tcph->seq_num.value();
+  uint8_t flags = tcph->flags;
+
+  for (uint32_t i = 0; i < nsegs; i++) {
+    bess::Packet *seg = segs[i];
+    uint32_t off = i * mss;
+    uint32_t len = std::min(mss, payload_len - off);
+    uint8_t *data = seg->head_data<uint8_t *>();
+
+    /* copy metadata (action, counters, ...) set by the upstream modules */
+    bess::utils::Copy(seg->metadata<void *>(), p->metadata<const void *>(),
+                      bess::metadata::kMetadataTotalSize);
+
+    bess::utils::Copy(data, eth, hdrs_len);
+    const void *src = rte_pktmbuf_read(reinterpret_cast<rte_mbuf *>(p),
+                                       hdrs_len + off, len, data + hdrs_len);
+    if (src != data + hdrs_len)
+      bess::utils::Copy(data + hdrs_len, src, len);
+    seg->set_data_len(hdrs_len + len);
+    seg->set_total_len(hdrs_len + len);
+
+    /* fix inner IP/TCP headers */
+    Ipv4 *s_iiph = (Ipv4 *)(data + inner_off);
+    Tcp *s_tcph = (Tcp *)(data + tcp_off);
+    uint16_t inner_len = hdrs_len - inner_off + len;
+    s_iiph->length = (be16_t)(inner_len);
+    s_iiph->id = (be16_t)(uint16_t)(ip_id + i);
+    s_iiph->checksum = 0;
+    s_iiph->checksum = CalculateIpv4Checksum(*s_iiph);
+
+    s_tcph->seq_num = (be32_t)(seq + off);
+    /* FIN/PSH only on the last segment, CWR only on the first one */
+    s_tcph->flags = flags;
+    if (i != nsegs - 1)
+      s_tcph->flags &= ~(Tcp::Flag::kFin | Tcp::Flag::kPsh);
+    if (i != 0)
+      s_tcph->flags &= ~TCP_FLAG_CWR;
+    s_tcph->checksum = 0;
+    s_tcph->checksum = CalculateIpv4TcpChecksum(*s_iiph, *s_tcph);
+
+    /* fix outer lengths */
+    Ipv4 *s_oiph = (Ipv4 *)(data + sizeof(Ethernet));
+    Udp *s_udph = (Udp *)(data + outer_off);
+    Gtpv1 *s_gtph = (Gtpv1 *)(data + gtp_off);
+    s_gtph->length = (be16_t)(inner_off - gtp_off - sizeof(Gtpv1) + inner_len);
+    s_udph->length = (be16_t)(inner_off - outer_off + inner_len);
+    s_oiph->length = (be16_t)(inner_off - sizeof(Ethernet) + inner_len);
+  }
+
+  for (uint32_t i = 0; i < nsegs; i++)
+    EmitPacket(ctx, segs[i], FORWARD_GATE);
+
+  /* free original super-packet, it went out in the segments */
+  bess::Packet::Free(p);
+  segmented++;
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+void GtpuGso::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    if (!SegmentPkt(ctx, p))
+      EmitPacket(ctx, p, FORWARD_GATE);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse GtpuGso::Init(const bess::pb::GtpuGsoArg &arg) {
+  eth_mtu = arg.mtu();
+
+  if (eth_mtu <= RTE_ETHER_MIN_LEN || eth_mtu > SNBUF_DATA)
+    return CommandFailure(EINVAL, "Invalid MTU size!");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+std::string GtpuGso::GetDesc() const {
+  return bess::utils::Format("mtu %d, %lu segmented", eth_mtu, segmented);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(GtpuGso, "gtpu_gso",
+           "Segments GTP-U encapsulated TCP super-packets to fit the MTU")
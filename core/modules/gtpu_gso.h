@@ -0,0 +1,33 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_GTPUGSO_H_
+#define BESS_MODULES_GTPUGSO_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for RTE_ETHER macros */
+#include <rte_ether.h>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Upper bound on the number of segments a single super-packet is split into
+ * (64KB IPv4 datagram / minimum MSS of 536B)
+ */
+#define GSO_MAX_SEGS 128
+/*----------------------------------------------------------------------------------*/
+class GtpuGso final : public Module {
+ public:
+  GtpuGso() { max_allowed_workers_ = Worker::kMaxWorkers; }
+
+  CommandResponse Init(const bess::pb::GtpuGsoArg &arg);
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  std::string GetDesc() const override;
+
+ private:
+  bool SegmentPkt(Context *ctx, bess::Packet *p);
+  int eth_mtu = RTE_ETHER_MAX_LEN;
+  uint64_t segmented = 0;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_GTPUGSO_H_
@@ -21,8 +21,54 @@ using bess::utils::Ipv4;
 using bess::utils::Tcp;
 using bess::utils::Udp;
 
-enum { DEFAULT_GATE = 0, FORWARD_GATE };
+enum { DEFAULT_GATE = 0, FORWARD_GATE, ERROR_IND_GATE, END_MARKER_GATE };
 const unsigned short UDP_PORT_GTPU = 2152;
+
+/* GTP-U message types */
+enum { GTPU_ERROR_IND = 26, GTPU_END_MARKER = 254, GTPU_GPDU = 255 };
+/* GTP-U IE types */
+enum { IE_RECOVERY = 14, IE_TEID_DATA_I = 16, IE_PEER_ADDRESS = 133 };
+
+const Commands GtpuParser::cmds = {
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&GtpuParser::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&GtpuParser::CommandSetStats), Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+/* finds the TEID Data I and (IPv4) GTP-U Peer Address IEs of an error
+ * indication, whose IEs end at `end'; false if either is missing */
+static bool parse_error_ind(const Gtpv1 *gtph, const uint8_t *end,
+                            be32_t *teid, be32_t *peer) {
+  const uint8_t *ie = (const uint8_t *)gtph + gtph->header_length();
+  bool has_teid = false, has_peer = false;
+
+  while (ie < end) {
+    if (*ie == IE_TEID_DATA_I) {
+      if (ie + 5 > end)
+        return false;
+      *teid = *(const be32_t *)(ie + 1);
+      has_teid = true;
+      ie += 5;
+    } else if (*ie == IE_RECOVERY) {
+      ie += 2;
+    } else if (*ie >= 128) {
+      /* TLV */
+      if (ie + 3 > end)
+        return false;
+      uint16_t len = (ie[1] << 8) | ie[2];
+      if (*ie == IE_PEER_ADDRESS && len == sizeof(be32_t) && ie + 7 <= end) {
+        *peer = *(const be32_t *)(ie + 3);
+        has_peer = true;
+      }
+      ie += 3 + len;
+    } else {
+      /* unknown TV IE, its length is unknown too */
+      break;
+    }
+  }
+
+  return has_teid && has_peer;
+}
 /*----------------------------------------------------------------------------------*/
 void GtpuParser::set_gtp_parsing_attrs(be32_t *sip, be32_t *dip, be16_t *sp,
                                        be16_t *dp, be32_t *teid, be32_t *tipd,
@@ -51,6 +97,7 @@ void GtpuParser::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
   Ipv4 *iph = NULL;
   Ethernet *eth = NULL;
   static const uint32_t _const_val = 0xFFFFFFFFu;
+  uint64_t tsc = stats_.Begin();
 
   for (int i = 0; i < cnt; i++) {
     bess::Packet *p = batch->pkts()[i];
@@ -58,6 +105,7 @@ void GtpuParser::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
     if (eth->ether_type != (be16_t)(Ethernet::kIpv4) &&
         eth->ether_type != (be16_t)(Ethernet::kArp)) {
       EmitPacket(ctx, p, DEFAULT_GATE);
+      stats_.Gate(ctx->wid, DEFAULT_GATE);
       continue;
     }
 
@@ -74,6 +122,35 @@ void GtpuParser::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
         if (udph->dst_port == (be16_t)(UDP_PORT_GTPU)) {
           Ipv4 *old_iph = iph;
           gtph = (Gtpv1 *)(udph + 1);
+          if (gtph->type == GTPU_ERROR_IND) {
+            const uint8_t *end =
+                (const uint8_t *)(gtph + 1) + gtph->length.value();
+            be32_t teid, peer;
+            if (end > p->head_data<uint8_t *>() + p->head_len() ||
+                !parse_error_ind(gtph, end, &teid, &peer)) {
+              EmitPacket(ctx, p, DEFAULT_GATE);
+              stats_.Gate(ctx->wid, DEFAULT_GATE);
+              continue;
+            }
+            set_gtp_parsing_attrs(&peer, &old_iph->dst, (be16_t *)&_const_val,
+                                  (be16_t *)&_const_val, &teid, &old_iph->dst,
+                                  &old_iph->protocol, p);
+            EmitPacket(ctx, p, ERROR_IND_GATE);
+            stats_.Gate(ctx->wid, ERROR_IND_GATE);
+            continue;
+          } else if (gtph->type == GTPU_END_MARKER) {
+            set_gtp_parsing_attrs(&old_iph->src, &old_iph->dst,
+                                  (be16_t *)&_const_val, (be16_t *)&_const_val,
+                                  &gtph->teid, &old_iph->dst,
+                                  &old_iph->protocol, p);
+            EmitPacket(ctx, p, END_MARKER_GATE);
+            stats_.Gate(ctx->wid, END_MARKER_GATE);
+            continue;
+          } else if (gtph->type != GTPU_GPDU) {
+            EmitPacket(ctx, p, DEFAULT_GATE);
+            stats_.Gate(ctx->wid, DEFAULT_GATE);
+            continue;
+          }
           be32_t teid = (be32_t)gtph->teid.value();
           /* reuse iph, tcph, and udph for innser headers too */
           iph = (Ipv4 *)((char *)gtph + gtph->header_length());
@@ -109,7 +186,9 @@ void GtpuParser::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
     }
 
     EmitPacket(ctx, p, FORWARD_GATE);
+    stats_.Gate(ctx->wid, FORWARD_GATE);
   }
+  stats_.End(ctx->wid, tsc, cnt);
 }
 /*----------------------------------------------------------------------------------*/
 CommandResponse GtpuParser::Init(const bess::pb::EmptyArg &) {
@@ -128,4 +207,16 @@ CommandResponse GtpuParser::Init(const bess::pb::EmptyArg &) {
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse GtpuParser::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse GtpuParser::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(GtpuParser, "gtpu_parser", "parsing module for gtp traffic")
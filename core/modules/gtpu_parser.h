@@ -8,6 +8,8 @@
 #include "../module.h"
 /* for endian types */
 #include "utils/endian.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 using bess::utils::be16_t;
 using bess::utils::be32_t;
 /*----------------------------------------------------------------------------------*/
@@ -22,14 +24,26 @@ typedef struct EpcMetadata {
   be32_t teid;
 } EpcMetadata;
 /*----------------------------------------------------------------------------------*/
+/**
+ * Parses packets into the 5-tuple/tunnel attributes PDR matching works on.
+ * GTP-U signalling is kept off the data path: Error Indications and End
+ * Markers leave through gates of their own, with `teid' and `src_ip' set to
+ * the tunnel in error (TEID Data I and peer address IEs), and `teid' and
+ * `tunnel_ipv4_dst' set to the tunnel the end marker came on, respectively.
+ * Other GTP-U messages than G-PDUs go to the default gate.
+ */
 class GtpuParser final : public Module {
  public:
   GtpuParser() { max_allowed_workers_ = Worker::kMaxWorkers; }
 
-  /* Gates: (0) Default, (1) Forward */
-  static const gate_idx_t kNumOGates = 2;
+  /* Gates: (0) Default, (1) Forward, (2) Error Indication, (3) End Marker */
+  static const gate_idx_t kNumOGates = 4;
+  static const Commands cmds;
   CommandResponse Init(const bess::pb::EmptyArg &);
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
 
  private:
   /* set attributes */
@@ -43,6 +57,9 @@ class GtpuParser final : public Module {
   int teid_id = -1;
   int tunnel_ip4_dst_id = -1;
   int proto_id = -1;
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 /*----------------------------------------------------------------------------------*/
 #endif  // BESS_MODULES_GTPUPARSER_H_
@@ -23,6 +23,12 @@ using bess::utils::ToIpv4Address;
 #define IP_FRAG_TBL_BUCKET_ENTRIES 16
 enum { DEFAULT_GATE = 0, FORWARD_GATE };
 /*----------------------------------------------------------------------------------*/
+const Commands IPDefrag::cmds = {
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&IPDefrag::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&IPDefrag::CommandSetStats), Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
 /**
  * Returns NULL if packet is fragmented and needs more for reassembly.
  * Returns Packet ptr if the packet is unfragmented, or is freshly reassembled.
@@ -61,6 +67,7 @@ bess::Packet *IPDefrag::IPReassemble(Context *ctx, bess::Packet *p) {
         DLOG(INFO) << "Failed to linearize rte_mbuf. "
                    << "Is there enough tail room?" << std::endl;
         EmitPacket(ctx, p, DEFAULT_GATE);
+        stats_.Gate(ctx->wid, DEFAULT_GATE);
         return NULL;
       }
     }
@@ -76,6 +83,7 @@ bess::Packet *IPDefrag::IPReassemble(Context *ctx, bess::Packet *p) {
 }
 /*----------------------------------------------------------------------------------*/
 void IPDefrag::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  uint64_t tsc = stats_.Begin();
   /* retire outdated frags (if needed) */
   if (ifdr.cnt != 0)
     rte_ip_frag_free_death_row(&ifdr, PREFETCH_OFFSET);
@@ -85,9 +93,12 @@ void IPDefrag::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
   for (int i = 0; i < cnt; i++) {
     bess::Packet *p = batch->pkts()[i];
     p = IPReassemble(ctx, p);
-    if (p)
+    if (p) {
       EmitPacket(ctx, p, FORWARD_GATE);
+      stats_.Gate(ctx->wid, FORWARD_GATE);
+    }
   }
+  stats_.End(ctx->wid, tsc, cnt);
 }
 /*----------------------------------------------------------------------------------*/
 void IPDefrag::DeInit() {
@@ -129,4 +140,16 @@ CommandResponse IPDefrag::Init(const bess::pb::IPDefragArg &arg) {
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse IPDefrag::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse IPDefrag::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(IPDefrag, "ip_defrag", "IP Reassembly module")
@@ -7,6 +7,8 @@
 /*----------------------------------------------------------------------------------*/
 #include "../module.h"
 #include "../pb/module_msg.pb.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 #include <rte_cycles.h>
 #include <rte_ip_frag.h>
 /*----------------------------------------------------------------------------------*/
@@ -16,10 +18,14 @@ class IPDefrag final : public Module {
 
   /* Gates: (0) Default, (1) Forward */
   static const gate_idx_t kNumOGates = 2;
+  static const Commands cmds;
 
   CommandResponse Init(const bess::pb::IPDefragArg &arg);
   void DeInit() override;
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
 
  private:
   bess::Packet *IPReassemble(Context *ctx, bess::Packet *p);
@@ -38,6 +44,10 @@ class IPDefrag final : public Module {
    * NUMA node where mem shall be allocated for IP frags
    */
   int32_t numa;
+
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 /*----------------------------------------------------------------------------------*/
 #endif  // BESS_MODULES_IPDEFRAG_H_
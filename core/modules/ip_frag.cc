@@ -21,9 +21,13 @@ using bess::utils::ToIpv4Address;
 
 enum { DEFAULT_GATE = 0, FORWARD_GATE };
 /*----------------------------------------------------------------------------------*/
-const Commands IPFrag::cmds = {{"get_eth_mtu", "EmptyArg",
-                                MODULE_CMD_FUNC(&IPFrag::GetEthMTU),
-                                Command::THREAD_SAFE}};
+const Commands IPFrag::cmds = {
+    {"get_eth_mtu", "EmptyArg", MODULE_CMD_FUNC(&IPFrag::GetEthMTU),
+     Command::THREAD_SAFE},
+    {"get_stats", "EmptyArg", MODULE_CMD_FUNC(&IPFrag::CommandGetStats),
+     Command::THREAD_SAFE},
+    {"set_stats", "ModuleStatsCommandSetArg",
+     MODULE_CMD_FUNC(&IPFrag::CommandSetStats), Command::THREAD_SAFE}};
 /*----------------------------------------------------------------------------------*/
 /**
  * Returns NULL under two conditions: (1) if the packet failed to fragment due
@@ -51,6 +55,7 @@ bess::Packet *IPFrag::FragmentPkt(Context *ctx, bess::Packet *p) {
     /* if the datagram is saying not to fragment (DF), we drop the packet */
     if ((iph->fragment_offset & RTE_IPV4_HDR_DF_FLAG) == RTE_IPV4_HDR_DF_FLAG) {
       EmitPacket(ctx, p, DEFAULT_GATE);
+      stats_.Gate(ctx->wid, DEFAULT_GATE);
       return NULL;
     }
 
@@ -73,6 +78,7 @@ bess::Packet *IPFrag::FragmentPkt(Context *ctx, bess::Packet *p) {
 
     if (unlikely(res < 0)) {
       EmitPacket(ctx, p, DEFAULT_GATE);
+      stats_.Gate(ctx->wid, DEFAULT_GATE);
       return NULL;
     } else {
       /* now copy the Ethernet header + IP payload to each frag */
@@ -138,6 +144,7 @@ bess::Packet *IPFrag::FragmentPkt(Context *ctx, bess::Packet *p) {
       }
       for (int i = 0; i < res; i++)
         EmitPacket(ctx, (bess::Packet *)frag_tbl[i], FORWARD_GATE);
+      stats_.Gate(ctx->wid, FORWARD_GATE, res);
 
       /* free original mbuf */
       DropPacket(ctx, p);
@@ -151,13 +158,17 @@ bess::Packet *IPFrag::FragmentPkt(Context *ctx, bess::Packet *p) {
 }
 /*----------------------------------------------------------------------------------*/
 void IPFrag::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  uint64_t tsc = stats_.Begin();
   int cnt = batch->cnt();
   for (int i = 0; i < cnt; i++) {
     bess::Packet *p = batch->pkts()[i];
     p = FragmentPkt(ctx, p);
-    if (p)
+    if (p) {
       EmitPacket(ctx, p, FORWARD_GATE);
+      stats_.Gate(ctx->wid, FORWARD_GATE);
+    }
   }
+  stats_.End(ctx->wid, tsc, cnt);
 }
 /*----------------------------------------------------------------------------------*/
 CommandResponse IPFrag::GetEthMTU(const bess::pb::EmptyArg &) {
@@ -188,4 +199,16 @@ CommandResponse IPFrag::Init(const bess::pb::IPFragArg &arg) {
   return CommandSuccess();
 }
 /*----------------------------------------------------------------------------------*/
+CommandResponse IPFrag::CommandGetStats(const bess::pb::EmptyArg &) {
+  bess::pb::ModuleStatsResponse r;
+  stats_.Get(&r);
+  return CommandSuccess(r);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse IPFrag::CommandSetStats(
+    const bess::pb::ModuleStatsCommandSetArg &arg) {
+  stats_.Set(arg.enable(), arg.clear());
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
 ADD_MODULE(IPFrag, "ip_frag", "IPv4 Fragmentation module")
@@ -12,6 +12,8 @@
 /* for RTE_ETHER macros */
 #include "../module.h"
 #include "../pb/module_msg.pb.h"
+/* for ModuleStats */
+#include "../utils/module_stats.h"
 #include "rte_ether.h"
 /*----------------------------------------------------------------------------------*/
 /**
@@ -58,12 +60,18 @@ class IPFrag final : public Module {
   CommandResponse Init(const bess::pb::IPFragArg &arg);
   void DeInit() override;
   void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  CommandResponse CommandGetStats(const bess::pb::EmptyArg &);
+  CommandResponse CommandSetStats(
+      const bess::pb::ModuleStatsCommandSetArg &arg);
   CommandResponse GetEthMTU(const bess::pb::EmptyArg &);
 
  private:
   bess::Packet *FragmentPkt(Context *ctx, bess::Packet *p);
   bess::DpdkPacketPool *indirect_pktmbuf_pool = NULL;
   int eth_mtu = RTE_ETHER_MAX_LEN;
+  /* opt-in cycle accounting, see set_stats */
+  bess::utils::ModuleStats<Worker::kMaxWorkers, bess::PacketBatch::kMaxBurst>
+      stats_;
 };
 /*----------------------------------------------------------------------------------*/
 #endif  // BESS_MODULES_IPFRAG_H_
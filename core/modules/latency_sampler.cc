@@ -0,0 +1,43 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for latency_sampler decls */
+#include "latency_sampler.h"
+/* for rdtsc() */
+#include "utils/time.h"
+/*----------------------------------------------------------------------------------*/
+/* default of LatencySamplerArg.sample_every */
+static const uint32_t kDefaultSampleEvery = 1024;
+/*----------------------------------------------------------------------------------*/
+void LatencySampler::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+  uint32_t left = left_[ctx->wid].left;
+
+  for (int i = 0; i < cnt; i++) {
+    uint64_t ts = 0;
+
+    if (--left == 0) {
+      left = sample_every_;
+      ts = rdtsc();
+    }
+    set_attr<uint64_t>(this, ts_attr_, batch->pkts()[i], ts);
+  }
+  left_[ctx->wid].left = left;
+
+  RunNextModule(ctx, batch);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse LatencySampler::Init(const bess::pb::LatencySamplerArg &arg) {
+  sample_every_ = arg.sample_every() ?: kDefaultSampleEvery;
+  for (int i = 0; i < Worker::kMaxWorkers; i++)
+    left_[i].left = sample_every_;
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  ts_attr_ = AddMetadataAttr("ts", sizeof(uint64_t), AccessMode::kWrite);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(LatencySampler, "latency_sampler",
+           "stamps sampled packets with their arrival time for Counter")
@@ -0,0 +1,36 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_LATENCYSAMPLER_H_
+#define BESS_MODULES_LATENCYSAMPLER_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/*----------------------------------------------------------------------------------*/
+/**
+ * Stamps one packet in sample_every with its arrival TSC in the `ts'
+ * attribute, and the others with 0, for the Counters downstream that record
+ * per-session latency. Only sampled packets cost a TSC read; the others cost
+ * a metadata store.
+ */
+class LatencySampler final : public Module {
+ public:
+  LatencySampler() : left_() { max_allowed_workers_ = Worker::kMaxWorkers; }
+
+  CommandResponse Init(const bess::pb::LatencySamplerArg &arg);
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+
+ private:
+  /* packets left until the next sample, per worker */
+  struct alignas(64) Countdown {
+    uint32_t left;
+  };
+
+  Countdown left_[Worker::kMaxWorkers];
+  uint32_t sample_every_ = 0;
+
+  int ts_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_LATENCYSAMPLER_H_
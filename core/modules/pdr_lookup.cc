@@ -0,0 +1,1191 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for pdr_lookup decls */
+#include "pdr_lookup.h"
+/* for uint64_to_bin() */
+#include "utils/endian.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for ParseIpv4Address() */
+#include "utils/ip.h"
+/* for PdrKeyOf() */
+#include "utils/pdr_key.h"
+/* for rte_hash_crc() */
+#include <rte_hash_crc.h>
+/* for rte_zmalloc_socket() */
+#include <rte_malloc.h>
+/* for rte_prefetch0() */
+#include <rte_prefetch.h>
+#include <algorithm>
+#include <set>
+#include <sstream>
+
+using bess::utils::be16_t;
+using bess::utils::be32_t;
+using bess::utils::ExtractField;
+using bess::utils::kNoTeid;
+using bess::utils::MakePdrKey;
+using bess::utils::PdrKeyKindOf;
+using bess::utils::RangeClassifier;
+using bess::utils::TEID_KEY;
+using bess::utils::UE_KEY;
+/*----------------------------------------------------------------------------------*/
+enum { QER_FAIL_GATE = 3, FAR_FAIL_GATE = 4 };
+
+/* largest UE pool with an array: a /12, 1M slots */
+static const int kMinUePoolPrefix = 12;
+
+/* largest TEID range with an array, and the size it starts out with */
+static const uint32_t kMaxTeidRange = 1u << 24;
+static const uint32_t kMinTeidSlots = 1024;
+
+/**
+ * Array slot of an address or TEID with records under more than one
+ * src_iface: the slot can only hold one of them, so lookups fall back to the
+ * hash table.
+ */
+static PdrSession *const kSharedSlot = reinterpret_cast<PdrSession *>(1);
+
+/* records with this many PDRs get a classifier rather than being scanned */
+static const uint32_t kMinClassifierRules = 8;
+static const uint32_t kMaxClassifierRules = 1024;
+
+/* kFields indices of the fields `ranges' may be given for */
+enum { SRC_PORT_FIELD = 5, DST_PORT_FIELD = 6 };
+
+struct FieldSpec {
+  const char *name;
+  size_t off;
+  int size;
+};
+
+static const FieldSpec kFields[] = {
+    {"src_iface", offsetof(PdrKey, f.src_iface), 1},
+    {"tunnel_ipv4_dst", offsetof(PdrKey, f.tunnel_ipv4_dst), 4},
+    {"teid", offsetof(PdrKey, f.teid), 4},
+    {"src_ip", offsetof(PdrKey, f.src_ip), 4},
+    {"dst_ip", offsetof(PdrKey, f.dst_ip), 4},
+    {"src_port", offsetof(PdrKey, f.src_port), 2},
+    {"dst_port", offsetof(PdrKey, f.dst_port), 2},
+    {"ip_proto", offsetof(PdrKey, f.ip_proto), 1},
+};
+
+static const int kFieldsCount = sizeof(kFields) / sizeof(kFields[0]);
+
+static const FieldSpec kValues[] = {
+    {"pdr_id", offsetof(PdrAction, pdr_id), 4},
+    {"fseid", offsetof(PdrAction, fseid), 8},
+    {"ctr_id", offsetof(PdrAction, ctr_id), 4},
+    {"qer_id", offsetof(PdrAction, qer_id), 4},
+    {"far_id", offsetof(PdrAction, far_id), 4},
+};
+
+static const FieldSpec kQerValues[] = {
+    {"qfi", offsetof(QerAction, qfi), 1},
+    {"ulStatus", offsetof(QerAction, ul_status), 1},
+    {"dlStatus", offsetof(QerAction, dl_status), 1},
+    {"ulMbr", offsetof(QerAction, ul_mbr), 4},
+    {"dlMbr", offsetof(QerAction, dl_mbr), 4},
+    {"ulGbr", offsetof(QerAction, ul_gbr), 4},
+    {"dlGbr", offsetof(QerAction, dl_gbr), 4},
+};
+
+static const FieldSpec kFarValues[] = {
+    {"action", offsetof(FarAction, action), 1},
+    {"tunnel_out_type", offsetof(FarAction, tunnel_out_type), 1},
+    {"tunnel_out_src_ip4addr", offsetof(FarAction, tunnel_out_src_ip4addr), 4},
+    {"tunnel_out_dst_ip4addr", offsetof(FarAction, tunnel_out_dst_ip4addr), 4},
+    {"tunnel_out_teid", offsetof(FarAction, tunnel_out_teid), 4},
+    {"tunnel_out_udp_port", offsetof(FarAction, tunnel_out_udp_port), 2},
+};
+
+/* qer_id/far_id and fseid, the ExactMatch fields of both tables */
+static const FieldSpec kActionKeyFields[] = {
+    {"id", 0, 4},
+    {"fseid", sizeof(uint32_t), 8},
+};
+
+static const FieldSpec *Spec(const QerAction *, int *n) {
+  *n = sizeof(kQerValues) / sizeof(kQerValues[0]);
+  return kQerValues;
+}
+
+static const FieldSpec *Spec(const FarAction *, int *n) {
+  *n = sizeof(kFarValues) / sizeof(kFarValues[0]);
+  return kFarValues;
+}
+
+/**
+ * Copies `fds' to the `n' fields of `out' described by `spec'. Returns the
+ * index of the first bad one, -1 if all went fine.
+ */
+static int ExtractFields(
+    const google::protobuf::RepeatedPtrField<bess::pb::FieldData> &fds,
+    const FieldSpec *spec, int n, bool be, void *out) {
+  for (int i = 0; i < n; i++) {
+    uint8_t *p = reinterpret_cast<uint8_t *>(out) + spec[i].off;
+    if (!ExtractField(fds.Get(i), spec[i].size, be, p))
+      return i;
+  }
+
+  return -1;
+}
+
+/* writes the `n' fields of `src' described by `spec' to attributes `attrs' */
+static inline void SetAttrs(Module *m, const int *attrs, const FieldSpec *spec,
+                            int n, const void *src, bess::Packet *p) {
+  for (int i = 0; i < n; i++) {
+    const uint8_t *v = reinterpret_cast<const uint8_t *>(src) + spec[i].off;
+    switch (spec[i].size) {
+      case 1:
+        set_attr<uint8_t>(m, attrs[i], p, *v);
+        break;
+      case 2:
+        set_attr<uint16_t>(m, attrs[i], p, *(const uint16_t *)v);
+        break;
+      case 4:
+        set_attr<uint32_t>(m, attrs[i], p, *(const uint32_t *)v);
+        break;
+      case 8:
+        set_attr<uint64_t>(m, attrs[i], p, *(const uint64_t *)v);
+        break;
+    }
+  }
+}
+
+/* points `slot' at `s', the new record of `skey' (NULL if it's gone) */
+static void UpdateSlot(PdrSession **slot, uint64_t skey, PdrSession *s) {
+  PdrSession *cur;
+
+  if (slot == nullptr || (cur = *slot) == kSharedSlot)
+    return;
+  if (s != nullptr) {
+    /* another src_iface has records for this address/TEID too */
+    if (cur != nullptr && cur->skey != skey)
+      s = kSharedSlot;
+  } else if (cur == nullptr || cur->skey != skey) {
+    return;
+  }
+  __atomic_store_n(slot, s, __ATOMIC_RELEASE);
+}
+
+static bool SameMatch(const PdrRule &a, const PdrRule &b) {
+  return !memcmp(&a.value, &b.value, sizeof(PdrKey)) &&
+         !memcmp(&a.mask, &b.mask, sizeof(PdrKey)) &&
+         a.has_range == b.has_range &&
+         (!a.has_range ||
+          (a.src_port_lo == b.src_port_lo && a.src_port_hi == b.src_port_hi &&
+           a.dst_port_lo == b.dst_port_lo && a.dst_port_hi == b.dst_port_hi));
+}
+
+/* port ranges of `r' (its masks having matched already) */
+static inline bool MatchRanges(const PdrRule &r, const PdrKey &key) {
+  uint16_t sp = be16_t::swap(key.f.src_port);
+  uint16_t dp = be16_t::swap(key.f.dst_port);
+
+  return sp >= r.src_port_lo && sp <= r.src_port_hi && dp >= r.dst_port_lo &&
+         dp <= r.dst_port_hi;
+}
+
+/* fields of `key' in host order, as the classifier dimensions */
+static inline void HostKey(const PdrKey &key, uint32_t *out) {
+  out[0] = key.f.src_iface;
+  out[1] = be32_t::swap(key.f.tunnel_ipv4_dst);
+  out[2] = be32_t::swap(key.f.teid);
+  out[3] = be32_t::swap(key.f.src_ip);
+  out[4] = be32_t::swap(key.f.dst_ip);
+  out[5] = be16_t::swap(key.f.src_port);
+  out[6] = be16_t::swap(key.f.dst_port);
+  out[7] = key.f.ip_proto;
+}
+
+/**
+ * Range of values rule `r' matches in every field (host order), false if a
+ * mask is not a prefix and can't be expressed as one range.
+ */
+static bool RuleRanges(const PdrRule &r, RangeClassifier::Range *out) {
+  uint32_t value[kFieldsCount], mask[kFieldsCount];
+
+  HostKey(r.value, value);
+  HostKey(r.mask, mask);
+  for (int i = 0; i < kFieldsCount; i++) {
+    uint32_t max = kFields[i].size == 4 ? UINT32_MAX
+                                        : (1u << (8 * kFields[i].size)) - 1;
+    uint32_t wild = ~mask[i] & max;
+
+    /* contiguous high bits */
+    if (wild & (wild + 1))
+      return false;
+    out[i].lo = value[i];
+    out[i].hi = value[i] | wild;
+  }
+  if (r.has_range) {
+    RangeClassifier::Range *sp = &out[SRC_PORT_FIELD];
+    RangeClassifier::Range *dp = &out[DST_PORT_FIELD];
+    /* a port without a range still has its mask: [0, 65535] otherwise */
+    sp->lo = std::max<uint32_t>(sp->lo, r.src_port_lo);
+    sp->hi = std::min<uint32_t>(sp->hi, r.src_port_hi);
+    dp->lo = std::max<uint32_t>(dp->lo, r.dst_port_lo);
+    dp->hi = std::min<uint32_t>(dp->hi, r.dst_port_hi);
+  }
+
+  return true;
+}
+
+/* classifier of `n' rules, NULL if they are better scanned */
+static RangeClassifier *BuildClassifier(const PdrRule *rules, uint32_t n) {
+  if (n < kMinClassifierRules || n > kMaxClassifierRules)
+    return nullptr;
+
+  std::vector<RangeClassifier::Range> ranges(n * kFieldsCount);
+  for (uint32_t i = 0; i < n; i++) {
+    if (!RuleRanges(rules[i], &ranges[i * kFieldsCount]))
+      return nullptr;
+  }
+
+  return RangeClassifier::Create(ranges.data(), n, kFieldsCount,
+                                 rte_socket_id());
+}
+
+static void FreeSession(PdrSession *s) {
+  if (s != nullptr)
+    RangeClassifier::Free(s->cls);
+  rte_free(s);
+}
+
+static std::vector<PdrRule> RulesOf(const PdrSession *s) {
+  if (s == nullptr)
+    return std::vector<PdrRule>();
+  return std::vector<PdrRule>(s->rules, s->rules + s->num_rules);
+}
+/*----------------------------------------------------------------------------------*/
+const Commands PdrLookup::cmds = {
+    {"add", "WildcardMatchCommandAddArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandAdd), Command::THREAD_SAFE},
+    {"delete", "WildcardMatchCommandDeleteArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandDelete), Command::THREAD_SAFE},
+    {"add_bulk", "WildcardMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandAddBulk), Command::THREAD_SAFE},
+    {"delete_bulk", "WildcardMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandDeleteBulk), Command::THREAD_SAFE},
+    {"clear", "EmptyArg", MODULE_CMD_FUNC(&PdrLookup::CommandClear),
+     Command::THREAD_SAFE},
+    {"set_default_gate", "WildcardMatchCommandSetDefaultGateArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandSetDefaultGate),
+     Command::THREAD_SAFE},
+    {"qer_add", "ExactMatchCommandAddArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandQerAdd), Command::THREAD_SAFE},
+    {"qer_delete", "ExactMatchCommandDeleteArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandQerDelete), Command::THREAD_SAFE},
+    {"qer_add_bulk", "ExactMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandQerAddBulk), Command::THREAD_SAFE},
+    {"qer_delete_bulk", "ExactMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandQerDeleteBulk),
+     Command::THREAD_SAFE},
+    {"qer_clear", "EmptyArg", MODULE_CMD_FUNC(&PdrLookup::CommandQerClear),
+     Command::THREAD_SAFE},
+    {"far_add", "ExactMatchCommandAddArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandFarAdd), Command::THREAD_SAFE},
+    {"far_delete", "ExactMatchCommandDeleteArg",
+     MODULE_CMD_FUNC(&PdrLookup::CommandFarDelete), Command::THREAD_SAFE},
+    {"far_add_bulk", "ExactMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandFarAddBulk), Command::THREAD_SAFE},
+    {"far_delete_bulk", "ExactMatchConfig",
+     MODULE_CMD_FUNC(&PdrLookup::CommandFarDeleteBulk),
+     Command::THREAD_SAFE},
+    {"far_clear", "EmptyArg", MODULE_CMD_FUNC(&PdrLookup::CommandFarClear),
+     Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+template <typename T>
+CommandResponse PdrLookup::ExtractKeyMask(const T &arg, PdrKey *key,
+                                          PdrKey *mask) {
+  int i;
+
+  if (arg.values_size() != kNumFields)
+    return CommandFailure(EINVAL, "must specify %d values", kNumFields);
+  if (arg.masks_size() != kNumFields)
+    return CommandFailure(EINVAL, "must specify %d masks", kNumFields);
+
+  memset(key, 0, sizeof(*key));
+  memset(mask, 0, sizeof(*mask));
+  if ((i = ExtractFields(arg.values(), kFields, kNumFields, true, key)) >= 0)
+    return CommandFailure(EINVAL, "idx %d: not a correct %d-byte value", i,
+                          kFields[i].size);
+  if ((i = ExtractFields(arg.masks(), kFields, kNumFields, true, mask)) >= 0)
+    return CommandFailure(EINVAL, "idx %d: not a correct %d-byte mask", i,
+                          kFields[i].size);
+  for (i = 0; i < 3; i++)
+    key->w[i] &= mask->w[i];
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::ExtractRanges(
+    const bess::pb::WildcardMatchCommandAddArg &arg, PdrRule *rule) {
+  uint16_t lo[2] = {0, 0}, hi[2] = {UINT16_MAX, UINT16_MAX};
+  uint16_t *values[2] = {&rule->value.f.src_port, &rule->value.f.dst_port};
+  uint16_t *masks[2] = {&rule->mask.f.src_port, &rule->mask.f.dst_port};
+
+  if (arg.ranges_size() == 0)
+    return CommandSuccess();
+  if (arg.ranges_size() != kNumFields)
+    return CommandFailure(EINVAL, "must specify %d ranges", kNumFields);
+
+  for (int i = 0; i < kNumFields; i++) {
+    int j = i == SRC_PORT_FIELD ? 0 : i == DST_PORT_FIELD ? 1 : -1;
+    uint32_t end = 0;
+    uint16_t start = 0;
+
+    if (!ExtractField(arg.ranges(i), kFields[i].size, false, &end))
+      return CommandFailure(EINVAL, "idx %d: not a correct %d-byte range", i,
+                            kFields[i].size);
+    if (end == 0)
+      continue;
+    if (j < 0)
+      return CommandFailure(EINVAL, "idx %d: ranges are for ports only", i);
+    ExtractField(arg.values(i), 2, false, &start);
+    if (start > end)
+      return CommandFailure(EINVAL, "idx %d: empty range %u-%u", i, start,
+                            end);
+
+    /* the range replaces the value and mask of the port */
+    lo[j] = start;
+    hi[j] = end;
+    *values[j] = *masks[j] = 0;
+    rule->has_range = true;
+  }
+  rule->src_port_lo = lo[0];
+  rule->src_port_hi = hi[0];
+  rule->dst_port_lo = lo[1];
+  rule->dst_port_hi = hi[1];
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::ExtractActionKey(
+    const bess::pb::ExactMatchCommandAddArg &arg, ActionKey *key) {
+  uint8_t buf[sizeof(uint32_t) + sizeof(uint64_t)];
+  int i;
+
+  if (arg.fields_size() != 2)
+    return CommandFailure(EINVAL, "must specify 2 fields");
+  if ((i = ExtractFields(arg.fields(), kActionKeyFields, 2, false, buf)) >= 0)
+    return CommandFailure(EINVAL, "idx %d: not a correct %d-byte field", i,
+                          kActionKeyFields[i].size);
+  memcpy(&key->first, buf, sizeof(uint32_t));
+  memcpy(&key->second, buf + sizeof(uint32_t), sizeof(uint64_t));
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+bool PdrLookup::SessionKey(const PdrRule &rule, uint64_t *skey) const {
+  const PdrKey &v = rule.value;
+  const PdrKey &m = rule.mask;
+  uint64_t key = bess::utils::PdrKeyOf(v.f.src_iface, m.f.src_iface, v.f.teid,
+                                       m.f.teid, v.f.dst_ip, m.f.dst_ip);
+  int kind = PdrKeyKindOf(key);
+
+  if (kind != TEID_KEY && kind != UE_KEY)
+    return false;
+  *skey = key;
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+PdrSession *PdrLookup::FindSession(uint64_t skey) const {
+  void *data;
+
+  if (skey == 0)
+    return fallback_;
+  if (rte_hash_lookup_data(hash_, &skey, &data) < 0)
+    return nullptr;
+
+  return static_cast<PdrSession *>(data);
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::Resolve(PdrRule *rule) const {
+  if (!fused_)
+    return;
+
+  ActionKey qkey(rule->action.qer_id, rule->action.fseid);
+  auto qit = qers_.find(qkey);
+  rule->has_qer = qit != qers_.end();
+  if (rule->has_qer)
+    rule->qer = qit->second;
+
+  ActionKey fkey(rule->action.far_id, rule->action.fseid);
+  auto fit = fars_.find(fkey);
+  rule->has_far = fit != fars_.end();
+  if (rule->has_far)
+    rule->far = fit->second;
+}
+/*----------------------------------------------------------------------------------*/
+bool PdrLookup::Publish(uint64_t skey, PdrSession *old,
+                        const std::vector<PdrRule> &rules) {
+  PdrSession *s = nullptr;
+
+  if (!rules.empty()) {
+    size_t size = sizeof(PdrSession) + rules.size() * sizeof(PdrRule);
+    s = static_cast<PdrSession *>(rte_zmalloc_socket(
+        "pdr_session", size, alignof(PdrSession), rte_socket_id()));
+    if (s == nullptr)
+      return false;
+    s->skey = skey;
+    s->num_rules = rules.size();
+    for (size_t i = 0; i < rules.size(); i++) {
+      s->rules[i] = rules[i];
+      Resolve(&s->rules[i]);
+    }
+    /* built here, off the data path; NULL (scan) if that fails */
+    s->cls = BuildClassifier(s->rules, s->num_rules);
+
+    /* workers don't look past the slot of a TEID within the range */
+    if (PdrKeyKindOf(skey) == TEID_KEY && !GrowTeidTable((uint32_t)skey)) {
+      FreeSession(s);
+      return false;
+    }
+  }
+
+  /* the record is complete before a worker can see it */
+  if (skey == 0) {
+    __atomic_store_n(&fallback_, s, __ATOMIC_RELEASE);
+  } else if (s != nullptr) {
+    /* replaces the data of an existing key atomically */
+    if (rte_hash_add_key_data(hash_, &skey, s) < 0) {
+      FreeSession(s);
+      return false;
+    }
+  } else {
+    DelKey(skey);
+  }
+  if (PdrKeyKindOf(skey) == UE_KEY)
+    UpdateSlot(UeSlot((uint32_t)skey), skey, s);
+  else if (PdrKeyKindOf(skey) == TEID_KEY)
+    UpdateSlot(TeidSlot(teid_table_, (uint32_t)skey), skey, s);
+  if (old != nullptr)
+    qsbr_.Retire([old]() { FreeSession(old); });
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::DelKey(uint64_t skey) {
+  struct rte_hash *hash = hash_;
+  int32_t pos = rte_hash_del_key(hash, &skey);
+
+  /* lock-free tables keep the key slot until readers are done with it */
+  if (pos >= 0)
+    qsbr_.Retire([hash, pos]() { rte_hash_free_key_with_position(hash, pos); });
+}
+/*----------------------------------------------------------------------------------*/
+PdrSession **PdrLookup::UeSlot(uint32_t addr) const {
+  uint32_t a = be32_t::swap(addr);
+
+  for (const auto &pool : ue_pools_) {
+    if (a - pool.base < pool.size)
+      return &pool.slots[a - pool.base];
+  }
+
+  return nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+PdrSession **PdrLookup::TeidSlot(TeidTable *t, uint32_t teid) {
+  uint32_t i = be32_t::swap(teid) - t->base;
+
+  return i < t->size ? &t->slots[i] : nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+bool PdrLookup::GrowTeidTable(uint32_t teid) {
+  TeidTable *t = teid_table_;
+  uint32_t i = be32_t::swap(teid) - t->base;
+
+  if (i >= teid_range_ || i < t->size)
+    return true;
+
+  /* double it up to the range; TEIDs are allocated densely from the base */
+  uint32_t size = std::max(t->size, kMinTeidSlots);
+  while (size <= i)
+    size *= 2;
+  size = std::min(size, teid_range_);
+
+  TeidTable *nt = static_cast<TeidTable *>(
+      rte_zmalloc_socket("pdr_teid_table",
+                         sizeof(TeidTable) + size * sizeof(PdrSession *), 0,
+                         rte_socket_id()));
+  if (nt == nullptr)
+    return false;
+  nt->base = t->base;
+  nt->size = size;
+  memcpy(nt->slots, t->slots, t->size * sizeof(PdrSession *));
+
+  __atomic_store_n(&teid_table_, nt, __ATOMIC_RELEASE);
+  qsbr_.Retire([t]() { rte_free(t); });
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::Relink(uint64_t fseid) {
+  auto it = fseid_refs_.find(fseid);
+
+  if (it == fseid_refs_.end())
+    return;
+  for (const auto &ref : it->second) {
+    PdrSession *old = FindSession(ref.first);
+    /* on failure the old record (and its old actions) stays */
+    if (old != nullptr)
+      Publish(ref.first, old, RulesOf(old));
+  }
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::CountRule(const PdrRule &rule, uint64_t skey, int delta) {
+  uint8_t iface = rule.value.f.src_iface;
+
+  if (PdrKeyKindOf(skey) == TEID_KEY)
+    teid_rules_[iface] += delta;
+  else if (PdrKeyKindOf(skey) == UE_KEY)
+    ue_rules_[iface] += delta;
+  num_rules_ += delta;
+
+  auto &refs = fseid_refs_[rule.action.fseid];
+  if ((refs[skey] += delta) == 0) {
+    refs.erase(skey);
+    if (refs.empty())
+      fseid_refs_.erase(rule.action.fseid);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::ParseRule(
+    const bess::pb::WildcardMatchCommandAddArg &arg, PdrRule *rule) {
+  int i;
+
+  *rule = {};
+  if (arg.gate() >= MAX_GATES)
+    return CommandFailure(EINVAL, "Invalid gate: %lu", arg.gate());
+
+  CommandResponse err = ExtractKeyMask(arg, &rule->value, &rule->mask);
+  if (err.error().code() != 0)
+    return err;
+  err = ExtractRanges(arg, rule);
+  if (err.error().code() != 0)
+    return err;
+  if (arg.valuesv_size() != kNumValues)
+    return CommandFailure(EINVAL, "must specify %d values", kNumValues);
+  if ((i = ExtractFields(arg.valuesv(), kValues, kNumValues, false,
+                         &rule->action)) >= 0)
+    return CommandFailure(EINVAL, "idx %d: not a correct %d-byte value", i,
+                          kValues[i].size);
+  rule->priority = arg.priority();
+  rule->gate = arg.gate();
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+bool PdrLookup::InsertRule(const PdrRule &rule, bool *replaced,
+                           PdrRule *prev) {
+  uint64_t skey = 0;
+
+  SessionKey(rule, &skey);
+  PdrSession *old = FindSession(skey);
+  std::vector<PdrRule> rules = RulesOf(old);
+
+  /* same value and mask (and ranges): replace the old rule */
+  *replaced = false;
+  for (auto it = rules.begin(); it != rules.end(); it++) {
+    if (SameMatch(*it, rule)) {
+      *prev = *it;
+      rules.erase(it);
+      *replaced = true;
+      break;
+    }
+  }
+  auto pos = std::upper_bound(rules.begin(), rules.end(), rule,
+                              [](const PdrRule &a, const PdrRule &b) {
+                                return a.priority > b.priority;
+                              });
+  rules.insert(pos, rule);
+
+  if (!Publish(skey, old, rules))
+    return false;
+  if (*replaced)
+    CountRule(*prev, skey, -1);
+  CountRule(rule, skey, 1);
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+bool PdrLookup::DelRule(const PdrRule &probe) {
+  uint64_t skey = 0;
+
+  SessionKey(probe, &skey);
+
+  PdrSession *old = FindSession(skey);
+  std::vector<PdrRule> rules = RulesOf(old);
+  for (auto it = rules.begin(); it != rules.end(); it++) {
+    if (SameMatch(*it, probe)) {
+      PdrRule rule = *it;
+      rules.erase(it);
+      /* fails only if allocating the smaller record does */
+      if (!Publish(skey, old, rules))
+        return false;
+      CountRule(rule, skey, -1);
+      return true;
+    }
+  }
+
+  return false;
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::Clear() {
+  std::vector<std::pair<uint64_t, PdrSession *>> records;
+  const void *key;
+  void *data;
+  uint32_t next = 0;
+
+  /* deleting keys may move others around: collect them first */
+  while (rte_hash_iterate(hash_, &key, &data, &next) >= 0)
+    records.emplace_back(*static_cast<const uint64_t *>(key),
+                         static_cast<PdrSession *>(data));
+  for (const auto &r : records)
+    DelKey(r.first);
+  for (auto &pool : ue_pools_) {
+    for (uint32_t i = 0; i < pool.size; i++)
+      __atomic_store_n(&pool.slots[i], nullptr, __ATOMIC_RELAXED);
+  }
+  for (uint32_t i = 0; i < teid_table_->size; i++)
+    __atomic_store_n(&teid_table_->slots[i], nullptr, __ATOMIC_RELAXED);
+  records.emplace_back(0, fallback_);
+  __atomic_store_n(&fallback_, nullptr, __ATOMIC_RELEASE);
+  for (const auto &r : records) {
+    PdrSession *s = r.second;
+    if (s != nullptr)
+      qsbr_.Retire([s]() { FreeSession(s); });
+  }
+  memset(teid_rules_, 0, sizeof(teid_rules_));
+  memset(ue_rules_, 0, sizeof(ue_rules_));
+  num_rules_ = 0;
+  fseid_refs_.clear();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandAdd(
+    const bess::pb::WildcardMatchCommandAddArg &arg) {
+  Writer writer(this);
+  PdrRule rule, prev;
+  bool replaced;
+
+  CommandResponse err = ParseRule(arg, &rule);
+  if (err.error().code() != 0)
+    return err;
+  if (!InsertRule(rule, &replaced, &prev))
+    return CommandFailure(ENOMEM, "session table is full");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandDelete(
+    const bess::pb::WildcardMatchCommandDeleteArg &arg) {
+  Writer writer(this);
+  PdrRule probe = {};
+
+  /* rules with port ranges can only be deleted through delete_bulk */
+  CommandResponse err = ExtractKeyMask(arg, &probe.value, &probe.mask);
+  if (err.error().code() != 0)
+    return err;
+  if (!DelRule(probe))
+    return CommandFailure(ENOENT, "failed to delete a rule");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandAddBulk(
+    const bess::pb::WildcardMatchConfig &arg) {
+  Writer writer(this);
+  /* each rule added, and the one it replaced if any */
+  struct Applied {
+    PdrRule rule;
+    bool replaced;
+    PdrRule prev;
+  };
+  std::vector<Applied> done(arg.rules_size());
+
+  for (int i = 0; i < arg.rules_size(); i++) {
+    Applied &a = done[i];
+    CommandResponse err = ParseRule(arg.rules(i), &a.rule);
+    if (err.error().code() == 0 && !InsertRule(a.rule, &a.replaced, &a.prev))
+      err = CommandFailure(ENOMEM, "session table is full");
+    if (err.error().code() != 0) {
+      /* all or nothing: undo latest first, for rules given more than once */
+      for (int j = i - 1; j >= 0; j--) {
+        bool replaced;
+        PdrRule prev;
+        if (done[j].replaced)
+          InsertRule(done[j].prev, &replaced, &prev);
+        else
+          DelRule(done[j].rule);
+      }
+      return err;
+    }
+  }
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandDeleteBulk(
+    const bess::pb::WildcardMatchConfig &arg) {
+  Writer writer(this);
+  int failed = 0;
+
+  for (const auto &rule : arg.rules()) {
+    PdrRule probe = {};
+    CommandResponse err = ExtractKeyMask(rule, &probe.value, &probe.mask);
+    if (err.error().code() == 0)
+      err = ExtractRanges(rule, &probe);
+    if (err.error().code() != 0 || !DelRule(probe))
+      failed++;
+  }
+  if (failed)
+    return CommandFailure(ENOENT, "failed to delete %d of %d rules", failed,
+                          arg.rules_size());
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandClear(const bess::pb::EmptyArg &) {
+  Writer writer(this);
+  Clear();
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandSetDefaultGate(
+    const bess::pb::WildcardMatchCommandSetDefaultGateArg &arg) {
+  default_gate_ = arg.gate();
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+template <typename A>
+CommandResponse PdrLookup::AddAction(
+    std::map<ActionKey, A> *table,
+    const bess::pb::ExactMatchCommandAddArg &arg, AppliedAction<A> *applied) {
+  ActionKey key;
+  A action = {};
+  int n, i;
+  const FieldSpec *spec = Spec(&action, &n);
+
+  if (!fused_)
+    return CommandFailure(EINVAL, "QERs/FARs need fuse_qer_far");
+  CommandResponse err = ExtractActionKey(arg, &key);
+  if (err.error().code() != 0)
+    return err;
+  if (arg.values_size() != n)
+    return CommandFailure(EINVAL, "must specify %d values", n);
+  if ((i = ExtractFields(arg.values(), spec, n, false, &action)) >= 0)
+    return CommandFailure(EINVAL, "idx %d: not a correct %d-byte value", i,
+                          spec[i].size);
+
+  auto it = table->find(key);
+  applied->key = key;
+  applied->existed = it != table->end();
+  if (applied->existed)
+    applied->old = it->second;
+
+  (*table)[key] = action;
+  Relink(key.second);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+template <typename A>
+CommandResponse PdrLookup::AddActions(std::map<ActionKey, A> *table,
+                                      const bess::pb::ExactMatchConfig &arg) {
+  std::vector<AppliedAction<A>> done(arg.rules_size());
+
+  for (int i = 0; i < arg.rules_size(); i++) {
+    CommandResponse err = AddAction(table, arg.rules(i), &done[i]);
+    if (err.error().code() != 0) {
+      std::set<uint64_t> fseids;
+      /* undo latest first, for entries given more than once */
+      for (int j = i - 1; j >= 0; j--) {
+        if (done[j].existed)
+          (*table)[done[j].key] = done[j].old;
+        else
+          table->erase(done[j].key);
+        fseids.insert(done[j].key.second);
+      }
+      for (uint64_t fseid : fseids)
+        Relink(fseid);
+      return err;
+    }
+  }
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+template <typename A>
+bool PdrLookup::DelAction(std::map<ActionKey, A> *table,
+                          const bess::pb::ExactMatchCommandAddArg &arg) {
+  ActionKey key;
+
+  CommandResponse err = ExtractActionKey(arg, &key);
+  if (err.error().code() != 0 || table->erase(key) == 0)
+    return false;
+  Relink(key.second);
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandQerAdd(
+    const bess::pb::ExactMatchCommandAddArg &arg) {
+  Writer writer(this);
+  AppliedAction<QerAction> applied;
+
+  return AddAction(&qers_, arg, &applied);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandQerDelete(
+    const bess::pb::ExactMatchCommandDeleteArg &arg) {
+  Writer writer(this);
+  bess::pb::ExactMatchCommandAddArg rule;
+
+  *rule.mutable_fields() = arg.fields();
+  if (!DelAction(&qers_, rule))
+    return CommandFailure(ENOENT, "failed to delete a QER");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandQerAddBulk(
+    const bess::pb::ExactMatchConfig &arg) {
+  Writer writer(this);
+  return AddActions(&qers_, arg);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandQerDeleteBulk(
+    const bess::pb::ExactMatchConfig &arg) {
+  Writer writer(this);
+  int failed = 0;
+
+  for (const auto &rule : arg.rules())
+    failed += !DelAction(&qers_, rule);
+  if (failed)
+    return CommandFailure(ENOENT, "failed to delete %d of %d QERs", failed,
+                          arg.rules_size());
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandQerClear(const bess::pb::EmptyArg &) {
+  Writer writer(this);
+  std::map<ActionKey, QerAction> old;
+
+  old.swap(qers_);
+  for (const auto &q : old)
+    Relink(q.first.second);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandFarAdd(
+    const bess::pb::ExactMatchCommandAddArg &arg) {
+  Writer writer(this);
+  AppliedAction<FarAction> applied;
+
+  return AddAction(&fars_, arg, &applied);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandFarDelete(
+    const bess::pb::ExactMatchCommandDeleteArg &arg) {
+  Writer writer(this);
+  bess::pb::ExactMatchCommandAddArg rule;
+
+  *rule.mutable_fields() = arg.fields();
+  if (!DelAction(&fars_, rule))
+    return CommandFailure(ENOENT, "failed to delete a FAR");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandFarAddBulk(
+    const bess::pb::ExactMatchConfig &arg) {
+  Writer writer(this);
+  return AddActions(&fars_, arg);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandFarDeleteBulk(
+    const bess::pb::ExactMatchConfig &arg) {
+  Writer writer(this);
+  int failed = 0;
+
+  for (const auto &rule : arg.rules())
+    failed += !DelAction(&fars_, rule);
+  if (failed)
+    return CommandFailure(ENOENT, "failed to delete %d of %d FARs", failed,
+                          arg.rules_size());
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::CommandFarClear(const bess::pb::EmptyArg &) {
+  Writer writer(this);
+  std::map<ActionKey, FarAction> old;
+
+  old.swap(fars_);
+  for (const auto &f : old)
+    Relink(f.first.second);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::LookupSessions(const PdrKey *keys, int cnt, int kind,
+                               const PdrSession **sessions) const {
+  uint64_t skeys[bess::PacketBatch::kMaxBurst];
+  const void *key_ptrs[bess::PacketBatch::kMaxBurst];
+  void *data[bess::PacketBatch::kMaxBurst];
+  int idx[bess::PacketBatch::kMaxBurst];
+  TeidTable *teid_table = __atomic_load_n(&teid_table_, __ATOMIC_ACQUIRE);
+  uint64_t hit_mask = 0;
+  int n = 0;
+
+  for (int i = 0; i < cnt; i++) {
+    uint8_t iface = keys[i].f.src_iface;
+    PdrSession **slot;
+    const PdrSession *s;
+
+    sessions[i] = nullptr;
+    if (kind == TEID_KEY) {
+      if (!teid_rules_[iface] || keys[i].f.teid == kNoTeid)
+        continue;
+      skeys[n] = MakePdrKey(TEID_KEY, iface, keys[i].f.teid);
+      slot = TeidSlot(teid_table, keys[i].f.teid);
+    } else {
+      if (!ue_rules_[iface])
+        continue;
+      skeys[n] = MakePdrKey(UE_KEY, iface, keys[i].f.dst_ip);
+      slot = UeSlot(keys[i].f.dst_ip);
+    }
+
+    /* within an array, the slot is all there is */
+    if (slot != nullptr &&
+        (s = __atomic_load_n(slot, __ATOMIC_ACQUIRE)) != kSharedSlot) {
+      if (s != nullptr && s->skey == skeys[n]) {
+        rte_prefetch0(s->rules);
+        sessions[i] = s;
+      }
+      continue;
+    }
+    key_ptrs[n] = &skeys[n];
+    idx[n++] = i;
+  }
+  if (n == 0)
+    return;
+
+  rte_hash_lookup_bulk_data(hash_, key_ptrs, n, &hit_mask, data);
+  for (int j = 0; j < n; j++) {
+    if (!(hit_mask & (1ULL << j)))
+      continue;
+    const PdrSession *s = static_cast<const PdrSession *>(data[j]);
+    /* the record header and its first PDR */
+    rte_prefetch0(s);
+    rte_prefetch0(s->rules);
+    sessions[idx[j]] = s;
+  }
+}
+/*----------------------------------------------------------------------------------*/
+/* first PDR of `s' that matches `key' and beats `best' */
+static inline const PdrRule *MatchRules(const PdrSession *s, const PdrKey &key,
+                                        const PdrRule *best) {
+  if (s == nullptr)
+    return best;
+  if (s->cls != nullptr) {
+    uint32_t hkey[kFieldsCount];
+    HostKey(key, hkey);
+    int i = s->cls->Lookup(hkey);
+    if (i >= 0 && (best == nullptr || s->rules[i].priority > best->priority))
+      return &s->rules[i];
+    return best;
+  }
+  for (uint32_t i = 0; i < s->num_rules; i++) {
+    const PdrRule &r = s->rules[i];
+    if (best != nullptr && r.priority <= best->priority)
+      break;
+    if (r.Matches(key) && (!r.has_range || MatchRanges(r, key)))
+      return &r;
+  }
+
+  return best;
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  gate_idx_t default_gate = ACCESS_ONCE(default_gate_);
+  int cnt = batch->cnt();
+  PdrKey keys[bess::PacketBatch::kMaxBurst];
+  const PdrSession *teid_sessions[bess::PacketBatch::kMaxBurst];
+  const PdrSession *ue_sessions[bess::PacketBatch::kMaxBurst];
+
+  /* nothing this batch reads is freed until it's done */
+  qsbr_.Enter(ctx->wid);
+  const PdrSession *fallback = __atomic_load_n(&fallback_, __ATOMIC_ACQUIRE);
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    PdrKey *key = &keys[i];
+
+    key->w[0] = key->w[1] = key->w[2] = 0;
+    for (int j = 0; j < kNumFields; j++) {
+      bess::metadata::mt_offset_t off = attr_offset(field_attrs_[j]);
+      uint8_t *k = reinterpret_cast<uint8_t *>(key) + kFields[j].off;
+      switch (kFields[j].size) {
+        case 1:
+          *k = get_attr_with_offset<uint8_t>(off, p);
+          break;
+        case 2:
+          *(uint16_t *)k = get_attr_with_offset<uint16_t>(off, p);
+          break;
+        case 4:
+          *(uint32_t *)k = get_attr_with_offset<uint32_t>(off, p);
+          break;
+      }
+    }
+  }
+
+  /* stage 1 for the whole batch: find the sessions */
+  LookupSessions(keys, cnt, TEID_KEY, teid_sessions);
+  LookupSessions(keys, cnt, UE_KEY, ue_sessions);
+
+  /* stage 2: their PDRs */
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    const PdrRule *rule = MatchRules(teid_sessions[i], keys[i], nullptr);
+    rule = MatchRules(ue_sessions[i], keys[i], rule);
+    rule = MatchRules(fallback, keys[i], rule);
+
+    if (rule == nullptr) {
+      EmitPacket(ctx, p, default_gate);
+      continue;
+    }
+
+    SetAttrs(this, value_attrs_, kValues, kNumValues, &rule->action, p);
+    if (fused_) {
+      if (!rule->has_qer) {
+        EmitPacket(ctx, p, QER_FAIL_GATE);
+        continue;
+      }
+      if (!rule->has_far) {
+        EmitPacket(ctx, p, FAR_FAIL_GATE);
+        continue;
+      }
+      SetAttrs(this, qer_attrs_, kQerValues, kNumQerValues, &rule->qer, p);
+      SetAttrs(this, far_attrs_, kFarValues, kNumFarValues, &rule->far, p);
+    }
+    EmitPacket(ctx, p, rule->gate);
+  }
+  qsbr_.Exit(ctx->wid);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse PdrLookup::Init(const bess::pb::PdrLookupArg &arg) {
+  uint32_t max_sessions = arg.max_sessions();
+  std::ostringstream address;
+
+  if (max_sessions == 0)
+    return CommandFailure(EINVAL, "Invalid max_sessions");
+  fused_ = arg.fuse_qer_far();
+
+  for (const auto &prefix : arg.ue_pools()) {
+    size_t delim = prefix.find('/');
+    be32_t addr;
+    int len = -1;
+
+    if (delim != std::string::npos) {
+      len = atoi(prefix.c_str() + delim + 1);
+      if (!bess::utils::ParseIpv4Address(prefix.substr(0, delim), &addr))
+        len = -1;
+    }
+    if (len < kMinUePoolPrefix || len > 32)
+      return CommandFailure(EINVAL, "Invalid UE pool '%s' (/%d or longer)",
+                            prefix.c_str(), kMinUePoolPrefix);
+
+    UePool pool;
+    pool.size = 1u << (32 - len);
+    pool.base = addr.value() & ~(pool.size - 1);
+    pool.slots = static_cast<PdrSession **>(
+        rte_zmalloc_socket("pdr_ue_pool", pool.size * sizeof(PdrSession *), 0,
+                           rte_socket_id()));
+    if (pool.slots == nullptr)
+      return CommandFailure(ENOMEM, "Unable to allocate UE pool '%s'",
+                            prefix.c_str());
+    ue_pools_.push_back(pool);
+  }
+
+  /* starts out empty, grows as TEIDs within the range show up */
+  teid_range_ = arg.teid_range();
+  if (teid_range_ > kMaxTeidRange)
+    return CommandFailure(EINVAL, "teid_range is over %u", kMaxTeidRange);
+  teid_table_ = static_cast<TeidTable *>(rte_zmalloc_socket(
+      "pdr_teid_table", sizeof(TeidTable), 0, rte_socket_id()));
+  if (teid_table_ == nullptr)
+    return CommandFailure(ENOMEM, "Unable to allocate the TEID table");
+  teid_table_->base = arg.teid_base();
+
+  /* a session is keyed by its TEID uplink and by its UE address downlink */
+  address << this;
+  hash_name_ = "Pdr" + address.str();
+  struct rte_hash_parameters params = {};
+  params.name = hash_name_.c_str();
+  params.entries = std::max(2 * max_sessions, 64u);
+  params.key_len = sizeof(uint64_t);
+  params.hash_func = rte_hash_crc;
+  params.socket_id = (int)rte_socket_id();
+  /* workers look up lock-free while the (single) writer updates it */
+  params.extra_flag =
+      RTE_HASH_EXTRA_FLAGS_EXT_TABLE | RTE_HASH_EXTRA_FLAGS_RW_CONCURRENCY_LF;
+  hash_ = rte_hash_create(&params);
+  if (hash_ == nullptr)
+    return CommandFailure(ENOMEM, "Unable to create the session table");
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  for (int i = 0; i < kNumFields; i++)
+    field_attrs_[i] =
+        AddMetadataAttr(kFields[i].name, kFields[i].size, AccessMode::kRead);
+  for (int i = 0; i < kNumValues; i++)
+    value_attrs_[i] =
+        AddMetadataAttr(kValues[i].name, kValues[i].size, AccessMode::kWrite);
+  if (fused_) {
+    for (int i = 0; i < kNumQerValues; i++)
+      qer_attrs_[i] = AddMetadataAttr(kQerValues[i].name, kQerValues[i].size,
+                                      AccessMode::kWrite);
+    for (int i = 0; i < kNumFarValues; i++)
+      far_attrs_[i] = AddMetadataAttr(kFarValues[i].name, kFarValues[i].size,
+                                      AccessMode::kWrite);
+  }
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void PdrLookup::DeInit() {
+  if (hash_ != nullptr) {
+    Clear();
+    qsbr_.Drain();
+    rte_hash_free(hash_);
+    hash_ = nullptr;
+  }
+  for (auto &pool : ue_pools_)
+    rte_free(pool.slots);
+  ue_pools_.clear();
+  qsbr_.Drain();
+  rte_free(teid_table_);
+  teid_table_ = nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+std::string PdrLookup::GetDesc() const {
+  size_t sessions = hash_ != nullptr ? rte_hash_count(hash_) : 0;
+  size_t fallback = fallback_ != nullptr ? fallback_->num_rules : 0;
+
+  if (fused_)
+    return bess::utils::Format(
+        "%zu sessions, %zu PDRs (%zu fallback), %zu QERs, %zu FARs", sessions,
+        num_rules_, fallback, qers_.size(), fars_.size());
+  return bess::utils::Format("%zu sessions, %zu PDRs (%zu fallback)", sessions,
+                             num_rules_, fallback);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(PdrLookup, "pdr_lookup",
+           "Two-stage PDR classifier: session lookup, then its own PDRs")
@@ -0,0 +1,306 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_PDRLOOKUP_H_
+#define BESS_MODULES_PDRLOOKUP_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for Qsbr */
+#include "../utils/qsbr.h"
+/* for RangeClassifier */
+#include "../utils/range_classifier.h"
+/* for rte_hash */
+#include <rte_hash.h>
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Fields a PDR matches on, in the order of the pdrLookup fields in up4.bess.
+ * Addresses, ports and the TEID are kept in network order, the way
+ * GtpuParser writes them, so that packets are matched without swapping.
+ */
+struct PdrKey {
+  union {
+    struct {
+      uint32_t tunnel_ipv4_dst;
+      uint32_t teid;
+      uint32_t src_ip;
+      uint32_t dst_ip;
+      uint16_t src_port;
+      uint16_t dst_port;
+      uint8_t src_iface;
+      uint8_t ip_proto;
+      uint16_t pad;
+    } f;
+    uint64_t w[3];
+  };
+};
+
+/**
+ * Values a matching PDR writes (host order), in the order of the pdrLookup
+ * values in up4.bess.
+ */
+struct PdrAction {
+  uint32_t pdr_id;
+  uint64_t fseid;
+  uint32_t ctr_id;
+  uint32_t qer_id;
+  uint32_t far_id;
+};
+
+/* qerLookup values (host order) */
+struct QerAction {
+  uint8_t qfi;
+  uint8_t ul_status;
+  uint8_t dl_status;
+  uint32_t ul_mbr;
+  uint32_t dl_mbr;
+  uint32_t ul_gbr;
+  uint32_t dl_gbr;
+};
+
+/* farLookup values (host order) */
+struct FarAction {
+  uint8_t action;
+  uint8_t tunnel_out_type;
+  uint32_t tunnel_out_src_ip4addr;
+  uint32_t tunnel_out_dst_ip4addr;
+  uint32_t tunnel_out_teid;
+  uint16_t tunnel_out_udp_port;
+};
+
+/**
+ * A PDR with, when the table is fused, copies of the QER and FAR it links
+ * to, so that a match needs no further lookups. The match fields come first
+ * so that non-matching rules are rejected within the first cache line.
+ */
+struct alignas(64) PdrRule {
+  PdrKey value; /* already masked */
+  PdrKey mask;
+  int64_t priority;
+  gate_idx_t gate;
+  bool has_qer;
+  bool has_far;
+  /* ports are matched against these (host order) rather than masks */
+  bool has_range;
+  uint16_t src_port_lo, src_port_hi;
+  uint16_t dst_port_lo, dst_port_hi;
+  PdrAction action;
+  QerAction qer;
+  FarAction far;
+
+  bool Matches(const PdrKey &key) const {
+    return ((key.w[0] & mask.w[0]) == value.w[0]) &
+           ((key.w[1] & mask.w[1]) == value.w[1]) &
+           ((key.w[2] & mask.w[2]) == value.w[2]);
+  }
+};
+
+/**
+ * PDRs of one session that share the same stage-1 key, highest priority
+ * first, in one contiguous record. Records with many PDRs also get a
+ * classifier over them. Records are never modified in place: an
+ * update builds a new one and swaps it into the table, and the old one is
+ * freed once no worker can still be reading it.
+ */
+struct alignas(64) PdrSession {
+  uint64_t skey;
+  uint32_t num_rules;
+  bess::utils::RangeClassifier *cls; /* NULL: scan the rules */
+  PdrRule rules[0];
+};
+
+/**
+ * Stage-1 records of the UE addresses of a pool, indexed by (address - base),
+ * so that downlink packets find their session with a single array read.
+ */
+struct UePool {
+  uint32_t base; /* host order */
+  uint32_t size;
+  PdrSession **slots;
+};
+
+/**
+ * Stage-1 records of the TEIDs from base on, indexed by (TEID - base). It is
+ * grown (replaced by a larger copy) as higher TEIDs show up, up to a bound.
+ */
+struct TeidTable {
+  uint32_t base; /* host order */
+  uint32_t size;
+  PdrSession *slots[0];
+};
+/*----------------------------------------------------------------------------------*/
+/**
+ * Two-stage PDR classifier. Stage 1 finds the session with an exact lookup
+ * on (src_iface, teid) for tunneled packets, or on (src_iface, UE address)
+ * for the rest. Stage 2 walks that session's own PDRs. PDRs that pin down
+ * neither a TEID nor a UE address are kept in a (usually empty) fallback
+ * record that every packet is checked against, so that the highest priority
+ * match is the same one WildcardMatch would have picked.
+ *
+ * UE addresses within `ue_pools' are looked up in per-pool arrays rather than
+ * hashed; addresses outside of them still go to the hash table. Likewise,
+ * TEIDs within [teid_base, teid_base + teid_range) are looked up by index.
+ *
+ * Takes the same commands and arguments as the WildcardMatch pdrLookup table.
+ * On top of that, `ranges' can give port ranges, matched natively.
+ * With `fuse_qer_far', it also takes the qerLookup/farLookup (ExactMatch)
+ * rules through the qer_* and far_* commands, and writes the QER and FAR
+ * values of the matching PDR as well, replacing those two tables.
+ *
+ * Commands run alongside the workers: they publish complete records with
+ * atomic pointer swaps (and a lock-free rte_hash), and whatever they unlink
+ * is reclaimed through Qsbr, so workers never block nor see a partial rule.
+ */
+class PdrLookup final : public Module {
+ public:
+  PdrLookup() : default_gate_(), hash_(), teid_rules_(), ue_rules_() {
+    max_allowed_workers_ = Worker::kMaxWorkers;
+  }
+
+  /**
+   * Gates: (0) No decap, (1) Decap, (2) Lookup failure (default gate),
+   * (3) QER lookup failure, (4) FAR lookup failure
+   */
+  static const gate_idx_t kNumOGates = 5;
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::PdrLookupArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns the number of sessions and PDRs
+  std::string GetDesc() const override;
+
+  CommandResponse CommandAdd(const bess::pb::WildcardMatchCommandAddArg &arg);
+  CommandResponse CommandDelete(
+      const bess::pb::WildcardMatchCommandDeleteArg &arg);
+  CommandResponse CommandAddBulk(const bess::pb::WildcardMatchConfig &arg);
+  CommandResponse CommandDeleteBulk(const bess::pb::WildcardMatchConfig &arg);
+  CommandResponse CommandClear(const bess::pb::EmptyArg &arg);
+  CommandResponse CommandSetDefaultGate(
+      const bess::pb::WildcardMatchCommandSetDefaultGateArg &arg);
+
+  CommandResponse CommandQerAdd(const bess::pb::ExactMatchCommandAddArg &arg);
+  CommandResponse CommandQerDelete(
+      const bess::pb::ExactMatchCommandDeleteArg &arg);
+  CommandResponse CommandQerAddBulk(const bess::pb::ExactMatchConfig &arg);
+  CommandResponse CommandQerDeleteBulk(const bess::pb::ExactMatchConfig &arg);
+  CommandResponse CommandQerClear(const bess::pb::EmptyArg &arg);
+  CommandResponse CommandFarAdd(const bess::pb::ExactMatchCommandAddArg &arg);
+  CommandResponse CommandFarDelete(
+      const bess::pb::ExactMatchCommandDeleteArg &arg);
+  CommandResponse CommandFarAddBulk(const bess::pb::ExactMatchConfig &arg);
+  CommandResponse CommandFarDeleteBulk(const bess::pb::ExactMatchConfig &arg);
+  CommandResponse CommandFarClear(const bess::pb::EmptyArg &arg);
+
+ private:
+  enum { kNumFields = 8, kNumValues = 5, kNumQerValues = 7, kNumFarValues = 6 };
+  /* (qer_id or far_id, fseid) */
+  typedef std::pair<uint32_t, uint64_t> ActionKey;
+
+  template <typename T>
+  CommandResponse ExtractKeyMask(const T &arg, PdrKey *key, PdrKey *mask);
+  CommandResponse ExtractRanges(const bess::pb::WildcardMatchCommandAddArg &arg,
+                                PdrRule *rule);
+  CommandResponse ExtractActionKey(const bess::pb::ExactMatchCommandAddArg &arg,
+                                   ActionKey *key);
+
+  /* stage-1 key of a rule, false if it goes to the fallback record */
+  bool SessionKey(const PdrRule &rule, uint64_t *skey) const;
+  PdrSession *FindSession(uint64_t skey) const;
+  /* copies the linked QER and FAR into `rule' */
+  void Resolve(PdrRule *rule) const;
+  /* replaces the `skey' record (NULL for new ones) with one of `rules' */
+  bool Publish(uint64_t skey, PdrSession *old,
+               const std::vector<PdrRule> &rules);
+  /* rebuilds the records holding PDRs of session `fseid' */
+  void Relink(uint64_t fseid);
+  void CountRule(const PdrRule &rule, uint64_t skey, int delta);
+  /* deletes `skey' from the hash table, its slot freed after a grace period */
+  void DelKey(uint64_t skey);
+  /* array slot of UE address `addr' (network order), NULL if in no pool */
+  PdrSession **UeSlot(uint32_t addr) const;
+  /* array slot of `teid' (network order) in `t', NULL if out of it */
+  static PdrSession **TeidSlot(TeidTable *t, uint32_t teid);
+  /* makes room for `teid' if it is within the range, false if out of memory */
+  bool GrowTeidTable(uint32_t teid);
+
+  CommandResponse ParseRule(const bess::pb::WildcardMatchCommandAddArg &arg,
+                            PdrRule *rule);
+  /* sets *replaced (and *prev) if a rule with the same match was there */
+  bool InsertRule(const PdrRule &rule, bool *replaced, PdrRule *prev);
+  /* deletes the rule with the same match as `probe' */
+  bool DelRule(const PdrRule &probe);
+  void Clear();
+
+  /* an entry a command installed, and what it replaced */
+  template <typename A>
+  struct AppliedAction {
+    ActionKey key;
+    bool existed;
+    A old;
+  };
+
+  template <typename A>
+  CommandResponse AddAction(std::map<ActionKey, A> *table,
+                            const bess::pb::ExactMatchCommandAddArg &arg,
+                            AppliedAction<A> *applied);
+  /* all of `arg' or, on failure, none of it */
+  template <typename A>
+  CommandResponse AddActions(std::map<ActionKey, A> *table,
+                             const bess::pb::ExactMatchConfig &arg);
+  template <typename A>
+  bool DelAction(std::map<ActionKey, A> *table,
+                 const bess::pb::ExactMatchCommandAddArg &arg);
+
+  /* looks up the records of `cnt' packets with `kind' stage-1 keys */
+  void LookupSessions(const PdrKey *keys, int cnt, int kind,
+                      const PdrSession **sessions) const;
+
+  /* serializes the commands, and reclaims what they retired on the way out */
+  class Writer {
+   public:
+    explicit Writer(PdrLookup *m) : m_(m) { m_->lock_.lock(); }
+    ~Writer() {
+      m_->qsbr_.Reclaim();
+      m_->lock_.unlock();
+    }
+
+   private:
+    PdrLookup *m_;
+  };
+
+  std::mutex lock_;
+  bess::utils::Qsbr<Worker::kMaxWorkers> qsbr_;
+
+  gate_idx_t default_gate_;
+  bool fused_ = false;
+  struct rte_hash *hash_;
+  std::string hash_name_;
+  PdrSession *fallback_ = nullptr;
+  size_t num_rules_ = 0;
+  std::vector<UePool> ue_pools_;
+  TeidTable *teid_table_ = nullptr;
+  uint32_t teid_range_ = 0;
+
+  /* number of PDRs keyed by TEID / UE address, per src_iface */
+  uint32_t teid_rules_[256];
+  uint32_t ue_rules_[256];
+
+  /* QERs and FARs as installed by the control plane */
+  std::map<ActionKey, QerAction> qers_;
+  std::map<ActionKey, FarAction> fars_;
+  /* fseid -> (stage-1 key -> number of its PDRs there) */
+  std::map<uint64_t, std::map<uint64_t, uint32_t>> fseid_refs_;
+
+  int field_attrs_[kNumFields];
+  int value_attrs_[kNumValues];
+  int qer_attrs_[kNumQerValues];
+  int far_attrs_[kNumFarValues];
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_PDRLOOKUP_H_
@@ -0,0 +1,374 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for session_filter decls */
+#include "session_filter.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/* for PdrKeyOf() */
+#include "utils/pdr_key.h"
+/* for rte_socket_id() */
+#include <rte_lcore.h>
+/* for rte_zmalloc_socket() */
+#include <rte_malloc.h>
+/* for rte_prefetch0() */
+#include <rte_prefetch.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+#include <vector>
+
+using bess::utils::ANY_KEY;
+using bess::utils::ExtractField;
+using bess::utils::MakePdrKey;
+using bess::utils::PdrKeyKindOf;
+using bess::utils::TEID_KEY;
+using bess::utils::UE_KEY;
+using bess::utils::WILD_KEY;
+/*----------------------------------------------------------------------------------*/
+enum { FORWARD_GATE = 0, UNKNOWN_GATE };
+
+/* sizes of the pdrLookup fields, in their order in up4.bess */
+static const int kFieldSizes[] = {1, 4, 4, 4, 4, 2, 2, 1};
+enum { SRC_IFACE_FIELD = 0, TEID_FIELD = 2, DST_IP_FIELD = 4 };
+
+/* filter bits per key to size the filter for: well under 1% false positives */
+static const uint32_t kBitsPerKey = 16;
+
+/* multipliers picking the bit a key sets in each word of its block */
+alignas(32) static const uint32_t kSalts[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+const Commands SessionFilter::cmds = {
+    {"add", "WildcardMatchCommandAddArg",
+     MODULE_CMD_FUNC(&SessionFilter::CommandAdd), Command::THREAD_SAFE},
+    {"delete", "WildcardMatchCommandDeleteArg",
+     MODULE_CMD_FUNC(&SessionFilter::CommandDelete), Command::THREAD_SAFE},
+    {"add_bulk", "WildcardMatchConfig",
+     MODULE_CMD_FUNC(&SessionFilter::CommandAddBulk), Command::THREAD_SAFE},
+    {"delete_bulk", "WildcardMatchConfig",
+     MODULE_CMD_FUNC(&SessionFilter::CommandDeleteBulk), Command::THREAD_SAFE},
+    {"clear", "EmptyArg", MODULE_CMD_FUNC(&SessionFilter::CommandClear),
+     Command::THREAD_SAFE}};
+/*----------------------------------------------------------------------------------*/
+/* 64-bit mix: the block comes from the high half, the bits from the low one */
+static inline uint64_t Hash(uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdULL;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ULL;
+  k ^= k >> 33;
+  return k;
+}
+
+/* one bit per word of the block */
+static inline void BlockBits(uint64_t hash, uint32_t *bits) {
+  for (int i = 0; i < 8; i++)
+    bits[i] = 1u << (((uint32_t)hash * kSalts[i]) >> 27);
+}
+
+/* PdrLookup tells apart rules with the same masks but other port ranges */
+static void AppendRanges(const bess::pb::WildcardMatchCommandAddArg &arg,
+                         std::string *id) {
+  for (const auto &range : arg.ranges()) {
+    uint16_t end = 0;
+    ExtractField(range, sizeof(end), false, &end);
+    id->append(reinterpret_cast<const char *>(&end), sizeof(end));
+  }
+}
+
+static void AppendRanges(const bess::pb::WildcardMatchCommandDeleteArg &,
+                         std::string *) {}
+/*----------------------------------------------------------------------------------*/
+template <typename T>
+CommandResponse SessionFilter::ExtractRule(const T &arg, std::string *id,
+                                           uint64_t *key) {
+  /* network order, as GtpuParser writes them */
+  uint32_t value[kNumFields], mask[kNumFields];
+
+  if (arg.values_size() != kNumFields)
+    return CommandFailure(EINVAL, "must specify %d values", kNumFields);
+  if (arg.masks_size() != kNumFields)
+    return CommandFailure(EINVAL, "must specify %d masks", kNumFields);
+
+  id->clear();
+  for (int i = 0; i < kNumFields; i++) {
+    int size = kFieldSizes[i];
+    value[i] = mask[i] = 0;
+    if (!ExtractField(arg.values(i), size, true, &value[i]))
+      return CommandFailure(EINVAL, "idx %d: not a correct %d-byte value", i,
+                            size);
+    if (!ExtractField(arg.masks(i), size, true, &mask[i]))
+      return CommandFailure(EINVAL, "idx %d: not a correct %d-byte mask", i,
+                            size);
+    value[i] &= mask[i];
+    id->append(reinterpret_cast<const char *>(&value[i]), size);
+    id->append(reinterpret_cast<const char *>(&mask[i]), size);
+  }
+  AppendRanges(arg, id);
+
+  *key = bess::utils::PdrKeyOf(value[SRC_IFACE_FIELD], mask[SRC_IFACE_FIELD],
+                               value[TEID_FIELD], mask[TEID_FIELD],
+                               value[DST_IP_FIELD], mask[DST_IP_FIELD]);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+bool SessionFilter::Contains(uint64_t hash) const {
+  const Block *b = &blocks_[BlockOf(hash)];
+#ifdef __AVX2__
+  __m256i salts = _mm256_load_si256((const __m256i *)kSalts);
+  __m256i idx = _mm256_srli_epi32(
+      _mm256_mullo_epi32(_mm256_set1_epi32((uint32_t)hash), salts), 27);
+  __m256i bits = _mm256_sllv_epi32(_mm256_set1_epi32(1), idx);
+  __m256i words = _mm256_load_si256((const __m256i *)b->w);
+
+  /* all of `bits' set in `words' */
+  return _mm256_testc_si256(words, bits);
+#else
+  uint32_t bits[kBlockWords];
+
+  BlockBits(hash, bits);
+  for (int i = 0; i < kBlockWords; i++) {
+    if ((ACCESS_ONCE(b->w[i]) & bits[i]) != bits[i])
+      return false;
+  }
+
+  return true;
+#endif
+}
+/*----------------------------------------------------------------------------------*/
+void SessionFilter::AddKey(uint64_t key) {
+  int kind = PdrKeyKindOf(key);
+
+  if (kind == ANY_KEY) {
+    __atomic_add_fetch(&wild_all_, 1, __ATOMIC_RELEASE);
+    return;
+  }
+  if (kind == WILD_KEY) {
+    __atomic_add_fetch(&wild_[(uint8_t)(key >> 32)], 1, __ATOMIC_RELEASE);
+    return;
+  }
+
+  uint64_t hash = Hash(key);
+  uint32_t block = BlockOf(hash);
+  if (keys_[std::make_pair(block, key)]++ != 0)
+    return;
+
+  uint32_t bits[kBlockWords];
+  BlockBits(hash, bits);
+  for (int i = 0; i < kBlockWords; i++)
+    __atomic_fetch_or(&blocks_[block].w[i], bits[i], __ATOMIC_RELEASE);
+}
+/*----------------------------------------------------------------------------------*/
+void SessionFilter::DelKey(uint64_t key) {
+  int kind = PdrKeyKindOf(key);
+
+  if (kind == ANY_KEY) {
+    __atomic_sub_fetch(&wild_all_, 1, __ATOMIC_RELEASE);
+    return;
+  }
+  if (kind == WILD_KEY) {
+    __atomic_sub_fetch(&wild_[(uint8_t)(key >> 32)], 1, __ATOMIC_RELEASE);
+    return;
+  }
+
+  uint32_t block = BlockOf(Hash(key));
+  auto it = keys_.find(std::make_pair(block, key));
+  if (it == keys_.end() || --it->second != 0)
+    return;
+  keys_.erase(it);
+
+  /* the bits of the keys left: a subset of the old ones, so the workers
+   * never miss any of those keys, whatever word they see first */
+  uint32_t words[kBlockWords] = {};
+  for (it = keys_.lower_bound(std::make_pair(block, 0));
+       it != keys_.end() && it->first.first == block; it++) {
+    uint32_t bits[kBlockWords];
+    BlockBits(Hash(it->first.second), bits);
+    for (int i = 0; i < kBlockWords; i++)
+      words[i] |= bits[i];
+  }
+  for (int i = 0; i < kBlockWords; i++)
+    __atomic_store_n(&blocks_[block].w[i], words[i], __ATOMIC_RELEASE);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::AddRule(
+    const bess::pb::WildcardMatchCommandAddArg &arg, bool *added) {
+  std::string id;
+  uint64_t key;
+
+  *added = false;
+  CommandResponse err = ExtractRule(arg, &id, &key);
+  if (err.error().code() != 0)
+    return err;
+
+  /* an update of a rule pdrLookup has already: same key */
+  if (!rules_.emplace(id, key).second)
+    return CommandSuccess();
+  AddKey(key);
+  *added = true;
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+template <typename T>
+bool SessionFilter::DelRule(const T &arg) {
+  std::string id;
+  uint64_t key;
+
+  CommandResponse err = ExtractRule(arg, &id, &key);
+  if (err.error().code() != 0)
+    return false;
+
+  auto it = rules_.find(id);
+  if (it == rules_.end())
+    return false;
+  DelKey(it->second);
+  rules_.erase(it);
+
+  return true;
+}
+/*----------------------------------------------------------------------------------*/
+void SessionFilter::Clear() {
+  rules_.clear();
+  keys_.clear();
+  __atomic_store_n(&wild_all_, 0, __ATOMIC_RELEASE);
+  for (int i = 0; i < 256; i++)
+    __atomic_store_n(&wild_[i], 0, __ATOMIC_RELEASE);
+  for (uint32_t b = 0; b < num_blocks_; b++) {
+    for (int i = 0; i < kBlockWords; i++)
+      __atomic_store_n(&blocks_[b].w[i], 0, __ATOMIC_RELEASE);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::CommandAdd(
+    const bess::pb::WildcardMatchCommandAddArg &arg) {
+  std::lock_guard<std::mutex> guard(lock_);
+  bool added;
+
+  return AddRule(arg, &added);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::CommandDelete(
+    const bess::pb::WildcardMatchCommandDeleteArg &arg) {
+  std::lock_guard<std::mutex> guard(lock_);
+
+  if (!DelRule(arg))
+    return CommandFailure(ENOENT, "failed to delete a rule");
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::CommandAddBulk(
+    const bess::pb::WildcardMatchConfig &arg) {
+  std::lock_guard<std::mutex> guard(lock_);
+  std::vector<int> added_idx;
+
+  for (int i = 0; i < arg.rules_size(); i++) {
+    bool added;
+    CommandResponse err = AddRule(arg.rules(i), &added);
+    if (err.error().code() != 0) {
+      /* take back what this command added */
+      for (int j : added_idx)
+        DelRule(arg.rules(j));
+      return err;
+    }
+    if (added)
+      added_idx.push_back(i);
+  }
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::CommandDeleteBulk(
+    const bess::pb::WildcardMatchConfig &arg) {
+  std::lock_guard<std::mutex> guard(lock_);
+  int failed = 0;
+
+  for (const auto &rule : arg.rules()) {
+    if (!DelRule(rule))
+      failed++;
+  }
+  if (failed)
+    return CommandFailure(ENOENT, "failed to delete %d of %d rules", failed,
+                          arg.rules_size());
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::CommandClear(const bess::pb::EmptyArg &) {
+  std::lock_guard<std::mutex> guard(lock_);
+  Clear();
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void SessionFilter::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+  uint64_t teid_hash[bess::PacketBatch::kMaxBurst];
+  uint64_t ue_hash[bess::PacketBatch::kMaxBurst];
+  bool open[bess::PacketBatch::kMaxBurst];
+  bool open_all = ACCESS_ONCE(wild_all_) != 0;
+
+  /* hash both keys of every packet and fetch their blocks ahead */
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    uint8_t iface = get_attr<uint8_t>(this, src_iface_attr_, p);
+
+    open[i] = open_all || ACCESS_ONCE(wild_[iface]) != 0;
+    if (open[i])
+      continue;
+    teid_hash[i] = Hash(
+        MakePdrKey(TEID_KEY, iface, get_attr<uint32_t>(this, teid_attr_, p)));
+    ue_hash[i] = Hash(
+        MakePdrKey(UE_KEY, iface, get_attr<uint32_t>(this, dst_ip_attr_, p)));
+    rte_prefetch0(&blocks_[BlockOf(teid_hash[i])]);
+    rte_prefetch0(&blocks_[BlockOf(ue_hash[i])]);
+  }
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    bool known = open[i] || Contains(teid_hash[i]) || Contains(ue_hash[i]);
+
+    EmitPacket(ctx, p, known ? FORWARD_GATE : UNKNOWN_GATE);
+  }
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse SessionFilter::Init(const bess::pb::SessionFilterArg &arg) {
+  uint64_t bits = (uint64_t)2 * arg.max_sessions() * kBitsPerKey;
+
+  if (arg.max_sessions() == 0)
+    return CommandFailure(EINVAL, "Invalid max_sessions");
+
+  /* a TEID and a UE address per session */
+  num_blocks_ = 1;
+  while ((uint64_t)num_blocks_ * sizeof(Block) * 8 < bits)
+    num_blocks_ <<= 1;
+  blocks_ = static_cast<Block *>(rte_zmalloc_socket(
+      "session_filter", num_blocks_ * sizeof(Block), 64, rte_socket_id()));
+  if (blocks_ == nullptr)
+    return CommandFailure(ENOMEM, "Unable to allocate the filter");
+
+  using AccessMode = bess::metadata::Attribute::AccessMode;
+  src_iface_attr_ =
+      AddMetadataAttr("src_iface", sizeof(uint8_t), AccessMode::kRead);
+  teid_attr_ = AddMetadataAttr("teid", sizeof(uint32_t), AccessMode::kRead);
+  dst_ip_attr_ = AddMetadataAttr("dst_ip", sizeof(uint32_t), AccessMode::kRead);
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+void SessionFilter::DeInit() {
+  rte_free(blocks_);
+  blocks_ = nullptr;
+}
+/*----------------------------------------------------------------------------------*/
+std::string SessionFilter::GetDesc() const {
+  return bess::utils::Format("%zu keys, %u KiB", keys_.size(),
+                             num_blocks_ * (uint32_t)sizeof(Block) / 1024);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(SessionFilter, "session_filter",
+           "drops packets of no known TEID or UE address")
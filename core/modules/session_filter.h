@@ -0,0 +1,99 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_SESSIONFILTER_H_
+#define BESS_MODULES_SESSIONFILTER_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+/*----------------------------------------------------------------------------------*/
+/**
+ * Membership filter over the TEIDs and UE addresses that have PDRs, meant to
+ * sit right after GtpuParser so that packets of no session are dropped
+ * before they reach pdrLookup. It takes the same add/delete/clear commands
+ * (and arguments) as pdrLookup and keys PDRs the way PdrLookup does: by
+ * (src_iface, teid) if they match a TEID, by (src_iface, UE address)
+ * otherwise. PDRs that pin down neither let every packet of their src_iface
+ * through.
+ *
+ * It is a blocked Bloom filter: a key sets 8 bits in one 32-byte block, so
+ * checking a packet takes two cache line reads at most. False positives only
+ * let packets on to pdrLookup, which fails them as before; there are no false
+ * negatives. A deleted key's block is rebuilt from the keys left in it, which
+ * only ever clears bits, so commands update the filter while workers read it.
+ */
+class SessionFilter final : public Module {
+ public:
+  SessionFilter() : blocks_(), num_blocks_(), wild_(), wild_all_() {
+    max_allowed_workers_ = Worker::kMaxWorkers;
+  }
+
+  /* Gates: (0) Forward, (1) Unknown session */
+  static const gate_idx_t kNumOGates = 2;
+
+  static const Commands cmds;
+  CommandResponse Init(const bess::pb::SessionFilterArg &arg);
+  void DeInit() override;
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns the number of keys and the filter size
+  std::string GetDesc() const override;
+
+  CommandResponse CommandAdd(const bess::pb::WildcardMatchCommandAddArg &arg);
+  CommandResponse CommandDelete(
+      const bess::pb::WildcardMatchCommandDeleteArg &arg);
+  CommandResponse CommandAddBulk(const bess::pb::WildcardMatchConfig &arg);
+  CommandResponse CommandDeleteBulk(const bess::pb::WildcardMatchConfig &arg);
+  CommandResponse CommandClear(const bess::pb::EmptyArg &arg);
+
+ private:
+  enum { kNumFields = 8, kBlockWords = 8 };
+
+  struct alignas(32) Block {
+    uint32_t w[kBlockWords];
+  };
+
+  /**
+   * Identity of a PDR (its masked values, masks and ranges, as pdrLookup
+   * tells rules apart) and the filter key it maps to.
+   */
+  template <typename T>
+  CommandResponse ExtractRule(const T &arg, std::string *id, uint64_t *key);
+
+  uint32_t BlockOf(uint64_t hash) const {
+    return (hash >> 32) & (num_blocks_ - 1);
+  }
+  bool Contains(uint64_t hash) const;
+
+  /* sets *added if the rule wasn't there already */
+  CommandResponse AddRule(const bess::pb::WildcardMatchCommandAddArg &arg,
+                          bool *added);
+  template <typename T>
+  bool DelRule(const T &arg);
+  void AddKey(uint64_t key);
+  void DelKey(uint64_t key);
+  void Clear();
+
+  std::mutex lock_;
+
+  Block *blocks_;
+  uint32_t num_blocks_; /* a power of 2 */
+  /* number of PDRs open to any TEID and UE address, per src_iface / of any */
+  uint32_t wild_[256];
+  uint32_t wild_all_;
+
+  /* rule identity -> key */
+  std::map<std::string, uint64_t> rules_;
+  /* (block, key) -> number of rules with that key */
+  std::map<std::pair<uint32_t, uint64_t>, uint32_t> keys_;
+
+  int src_iface_attr_ = -1;
+  int teid_attr_ = -1;
+  int dst_ip_attr_ = -1;
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_SESSIONFILTER_H_
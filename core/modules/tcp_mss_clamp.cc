@@ -0,0 +1,121 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+/* for tcp_mss_clamp decls */
+#include "tcp_mss_clamp.h"
+/* for be16_t */
+#include "utils/endian.h"
+/* for ethernet header */
+#include "utils/ether.h"
+/* for ip header */
+#include "utils/ip.h"
+/* for UpdateChecksum16() */
+#include "utils/checksum.h"
+/* for GetDesc() */
+#include "utils/format.h"
+/*----------------------------------------------------------------------------------*/
+using bess::utils::be16_t;
+using bess::utils::Ethernet;
+using bess::utils::Ipv4;
+using bess::utils::Tcp;
+using bess::utils::UpdateChecksum16;
+
+#define IP_FRAG_OFFSET_MASK 0x1FFF
+/*----------------------------------------------------------------------------------*/
+/**
+ * Walks the TCP options of a SYN segment and lowers the MSS option to
+ * max_mss (if needed). Returns true if the segment was modified.
+ */
+bool TcpMssClamp::ClampMss(Tcp *tcph, const uint8_t *pkt_end) {
+  uint8_t *opt = (uint8_t *)(tcph + 1);
+  const uint8_t *opt_end = (uint8_t *)tcph + (tcph->offset << 2);
+
+  if (opt_end > pkt_end)
+    opt_end = pkt_end;
+
+  while (opt < opt_end) {
+    if (*opt == TCP_OPT_EOL)
+      break;
+    if (*opt == TCP_OPT_NOP) {
+      opt++;
+      continue;
+    }
+    /* every other option carries a length byte */
+    if (opt + 1 >= opt_end || opt[1] < 2 || opt + opt[1] > opt_end)
+      break;
+    if (*opt == TCP_OPT_MSS && opt[1] == TCP_OPT_MSS_LEN) {
+      uint16_t old_raw, new_raw;
+      memcpy(&old_raw, opt + 2, sizeof(old_raw));
+      if (be16_t::swap(old_raw) <= max_mss)
+        return false;
+
+      new_raw = be16_t::swap(max_mss);
+      memcpy(opt + 2, &new_raw, sizeof(new_raw));
+
+      /**
+       * A 16-bit field at an odd offset from the start of the TCP header
+       * straddles two checksum words and contributes its bytes swapped
+       */
+      if (((opt + 2) - (uint8_t *)tcph) & 1) {
+        old_raw = __builtin_bswap16(old_raw);
+        new_raw = __builtin_bswap16(new_raw);
+      }
+      tcph->checksum = UpdateChecksum16(tcph->checksum, old_raw, new_raw);
+      return true;
+    }
+    opt += opt[1];
+  }
+
+  return false;
+}
+/*----------------------------------------------------------------------------------*/
+void TcpMssClamp::ProcessBatch(Context *ctx, bess::PacketBatch *batch) {
+  int cnt = batch->cnt();
+
+  for (int i = 0; i < cnt; i++) {
+    bess::Packet *p = batch->pkts()[i];
+    Ethernet *eth = p->head_data<Ethernet *>();
+    const uint8_t *pkt_end = (uint8_t *)eth + p->head_len();
+
+    if (eth->ether_type != (be16_t)(Ethernet::kIpv4))
+      continue;
+
+    Ipv4 *iph = (Ipv4 *)(eth + 1);
+    /* only the first fragment carries the TCP header */
+    if (iph->protocol != Ipv4::kTcp ||
+        (iph->fragment_offset.value() & IP_FRAG_OFFSET_MASK) != 0)
+      continue;
+
+    Tcp *tcph = (Tcp *)((uint8_t *)iph + (iph->header_length << 2));
+    if ((uint8_t *)(tcph + 1) > pkt_end || !(tcph->flags & Tcp::Flag::kSyn))
+      continue;
+
+    if (ClampMss(tcph, pkt_end))
+      counts_[ctx->wid].clamped++;
+  }
+
+  RunNextModule(ctx, batch);
+}
+/*----------------------------------------------------------------------------------*/
+CommandResponse TcpMssClamp::Init(const bess::pb::TcpMssClampArg &arg) {
+  /* smallest MSS an IPv4 host must accept (RFC 879) */
+  if (arg.max_mss() < 536 || arg.max_mss() > UINT16_MAX)
+    return CommandFailure(EINVAL, "Invalid max_mss!");
+
+  max_mss = arg.max_mss();
+
+  return CommandSuccess();
+}
+/*----------------------------------------------------------------------------------*/
+std::string TcpMssClamp::GetDesc() const {
+  uint64_t clamped = 0;
+
+  for (int wid = 0; wid < Worker::kMaxWorkers; wid++)
+    clamped += counts_[wid].clamped;
+
+  return bess::utils::Format("max_mss %u, %lu clamped", max_mss, clamped);
+}
+/*----------------------------------------------------------------------------------*/
+ADD_MODULE(TcpMssClamp, "tcp_mss_clamp",
+           "Clamps the MSS option of TCP SYN segments")
@@ -0,0 +1,41 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_MODULES_TCPMSSCLAMP_H_
+#define BESS_MODULES_TCPMSSCLAMP_H_
+/*----------------------------------------------------------------------------------*/
+#include "../module.h"
+#include "../pb/module_msg.pb.h"
+/* for tcp header */
+#include "utils/tcp.h"
+/*----------------------------------------------------------------------------------*/
+/**
+ * TCP option kinds
+ */
+#define TCP_OPT_EOL 0
+#define TCP_OPT_NOP 1
+#define TCP_OPT_MSS 2
+#define TCP_OPT_MSS_LEN 4
+/*----------------------------------------------------------------------------------*/
+class TcpMssClamp final : public Module {
+ public:
+  TcpMssClamp() { max_allowed_workers_ = Worker::kMaxWorkers; }
+
+  CommandResponse Init(const bess::pb::TcpMssClampArg &arg);
+  void ProcessBatch(Context *ctx, bess::PacketBatch *batch) override;
+  // returns the number of rewritten SYN segments
+  std::string GetDesc() const override;
+
+ private:
+  bool ClampMss(bess::utils::Tcp *tcph, const uint8_t *pkt_end);
+  uint16_t max_mss = 0;
+
+  /* per worker, summed up by GetDesc() */
+  struct alignas(64) WorkerCounts {
+    uint64_t clamped;
+  };
+  WorkerCounts counts_[Worker::kMaxWorkers] = {};
+};
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_MODULES_TCPMSSCLAMP_H_
@@ -0,0 +1,94 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_HOLDDOWN_H_
+#define BESS_UTILS_HOLDDOWN_H_
+/*----------------------------------------------------------------------------------*/
+#include <cstdint>
+/* for rte_hash_crc_8byte() */
+#include <rte_hash_crc.h>
+/* for rte_socket_id() */
+#include <rte_lcore.h>
+/* for rte_zmalloc_socket() */
+#include <rte_malloc.h>
+
+namespace bess {
+namespace utils {
+
+/**
+ * Lets each key through at most once per holddown, by keeping the time it
+ * last went through in a set-associative table with a cache line per set.
+ * When a set overflows, its oldest key is forgotten and may go through
+ * early, never late. Workers may share a table without locks, with the same
+ * outcome at worst.
+ */
+class Holddown {
+ public:
+  Holddown() : sets_(), num_sets_(), holddown_ns_() {}
+
+  /* room for about `max_keys' keys, false if out of memory */
+  bool Init(uint32_t max_keys, uint64_t holddown_ns) {
+    num_sets_ = 1;
+    while (num_sets_ * kWays < max_keys)
+      num_sets_ <<= 1;
+    holddown_ns_ = holddown_ns;
+    sets_ = static_cast<Set *>(rte_zmalloc_socket(
+        "holddown", num_sets_ * sizeof(Set), 64, rte_socket_id()));
+    return sets_ != nullptr;
+  }
+
+  void Free() {
+    rte_free(sets_);
+    sets_ = nullptr;
+  }
+
+  /* true if `key' went through less than a holddown before `now' */
+  bool Held(uint64_t key, uint64_t now) const {
+    const Set *s = &sets_[rte_hash_crc_8byte(key, 0) & (num_sets_ - 1)];
+
+    for (int i = 0; i < kWays; i++) {
+      if (s->ns[i] != 0 && s->key[i] == key)
+        return now - s->ns[i] < holddown_ns_;
+    }
+    return false;
+  }
+
+  /* true if `key' may go through at `now' (ns, not 0), which is recorded */
+  bool Due(uint64_t key, uint64_t now) {
+    Set *s = &sets_[rte_hash_crc_8byte(key, 0) & (num_sets_ - 1)];
+    int oldest = 0;
+
+    for (int i = 0; i < kWays; i++) {
+      if (s->ns[i] != 0 && s->key[i] == key) {
+        if (now - s->ns[i] < holddown_ns_)
+          return false;
+        s->ns[i] = now;
+        return true;
+      }
+      if (s->ns[i] < s->ns[oldest])
+        oldest = i;
+    }
+    s->key[oldest] = key;
+    s->ns[oldest] = now;
+
+    return true;
+  }
+
+ private:
+  static const int kWays = 4;
+
+  struct alignas(64) Set {
+    uint64_t key[kWays];
+    uint64_t ns[kWays]; /* 0: free */
+  };
+
+  Set *sets_;
+  uint32_t num_sets_; /* a power of 2 */
+  uint64_t holddown_ns_;
+};
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_HOLDDOWN_H_
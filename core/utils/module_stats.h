@@ -0,0 +1,130 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_MODULE_STATS_H_
+#define BESS_UTILS_MODULE_STATS_H_
+/*----------------------------------------------------------------------------------*/
+#include <cstdint>
+#include <cstring>
+/* for rdtsc() */
+#include "time.h"
+
+namespace bess {
+namespace utils {
+
+/**
+ * Opt-in accounting of where a module's cycles go: TSC cycles per batch and
+ * per packet (log2 buckets), batch sizes and packets per output gate. Each
+ * worker counts into its own cache lines without atomics; readers sum them
+ * up racily, which is good enough for statistics. While off, which is the
+ * default, Begin() and Gate() cost a predicted-not-taken branch each.
+ *
+ *   uint64_t tsc = stats_.Begin();
+ *   ... stats_.Gate(ctx->wid, gate) next to each EmitPacket() ...
+ *   stats_.End(ctx->wid, tsc, cnt);
+ */
+template <int kMaxWorkers, int kMaxBurst>
+class ModuleStats {
+ public:
+  static const int kCycleBuckets = 32;
+  static const int kMaxGates = 8; /* the last one counts the gates above */
+
+  ModuleStats() : enabled_(false), workers_() {}
+
+  bool enabled() const { return __atomic_load_n(&enabled_, __ATOMIC_RELAXED); }
+
+  /* called from commands */
+  void Set(bool enable, bool clear) {
+    if (clear)
+      memset(workers_, 0, sizeof(workers_));
+    __atomic_store_n(&enabled_, enable, __ATOMIC_RELAXED);
+  }
+
+  /* at the start of ProcessBatch(): the TSC, or 0 while off */
+  uint64_t Begin() const {
+    if (__builtin_expect(enabled(), 0))
+      return rdtsc();
+    return 0;
+  }
+
+  /* at the end of ProcessBatch(), with what Begin() returned */
+  void End(int wid, uint64_t start, int cnt) {
+    if (__builtin_expect(start == 0, 1))
+      return;
+    uint64_t cycles = rdtsc() - start;
+    PerWorker &w = workers_[wid];
+
+    w.batches++;
+    w.packets += cnt;
+    w.cycles += cycles;
+    w.batch_cycles[Log2(cycles)]++;
+    w.batch_size[cnt < kMaxBurst ? cnt : kMaxBurst]++;
+    if (cnt > 0)
+      w.packet_cycles[Log2(cycles / cnt)] += cnt;
+  }
+
+  /* `cnt' packets were emitted on `gate' */
+  void Gate(int wid, int gate, uint64_t cnt = 1) {
+    if (__builtin_expect(enabled(), 0))
+      workers_[wid].gates[gate < kMaxGates ? gate : kMaxGates - 1] += cnt;
+  }
+
+  /* fills a ModuleStatsResponse with the sum over workers */
+  template <typename Response>
+  void Get(Response *r) const {
+    PerWorker sum = {};
+
+    for (int i = 0; i < kMaxWorkers; i++) {
+      const PerWorker &w = workers_[i];
+      sum.batches += w.batches;
+      sum.packets += w.packets;
+      sum.cycles += w.cycles;
+      for (int j = 0; j < kCycleBuckets; j++) {
+        sum.batch_cycles[j] += w.batch_cycles[j];
+        sum.packet_cycles[j] += w.packet_cycles[j];
+      }
+      for (int j = 0; j <= kMaxBurst; j++)
+        sum.batch_size[j] += w.batch_size[j];
+      for (int j = 0; j < kMaxGates; j++)
+        sum.gates[j] += w.gates[j];
+    }
+
+    r->set_enabled(enabled());
+    r->set_batches(sum.batches);
+    r->set_packets(sum.packets);
+    r->set_cycles(sum.cycles);
+    for (int j = 0; j < kCycleBuckets; j++) {
+      r->add_batch_cycles(sum.batch_cycles[j]);
+      r->add_packet_cycles(sum.packet_cycles[j]);
+    }
+    for (int j = 0; j <= kMaxBurst; j++)
+      r->add_batch_size(sum.batch_size[j]);
+    for (int j = 0; j < kMaxGates; j++)
+      r->add_gate_packets(sum.gates[j]);
+  }
+
+ private:
+  struct alignas(64) PerWorker {
+    uint64_t batches;
+    uint64_t packets;
+    uint64_t cycles;
+    uint64_t batch_cycles[kCycleBuckets];  /* [i]: 2^i <= cycles < 2^(i+1) */
+    uint64_t packet_cycles[kCycleBuckets]; /* per packet, averaged per batch */
+    uint64_t batch_size[kMaxBurst + 1];
+    uint64_t gates[kMaxGates];
+  };
+
+  static int Log2(uint64_t v) {
+    int i = 63 - __builtin_clzll(v | 1);
+    return i < kCycleBuckets ? i : kCycleBuckets - 1;
+  }
+
+  bool enabled_;
+  PerWorker workers_[kMaxWorkers];
+};
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_MODULE_STATS_H_
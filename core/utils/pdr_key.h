@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_PDR_KEY_H_
+#define BESS_UTILS_PDR_KEY_H_
+/*----------------------------------------------------------------------------------*/
+#include <cstdint>
+#include <cstring>
+#include "../pb/module_msg.pb.h"
+/* for uint64_to_bin() */
+#include "endian.h"
+
+namespace bess {
+namespace utils {
+
+/* teid of packets GtpuParser found no GTP-U header in */
+static const uint32_t kNoTeid = 0xFFFFFFFFu;
+
+/**
+ * Kinds of keys a PDR maps to. PdrLookup finds the sessions of packets by
+ * TEID and UE keys; PDRs that pin down neither match every packet of their
+ * src_iface (WILD_KEY), or of all of them (ANY_KEY).
+ */
+enum PdrKeyKind { TEID_KEY = 1, UE_KEY = 2, WILD_KEY = 3, ANY_KEY = 4 };
+
+static inline uint64_t MakePdrKey(int kind, uint8_t iface, uint32_t id) {
+  return ((uint64_t)kind << 40) | ((uint64_t)iface << 32) | id;
+}
+
+static inline int PdrKeyKindOf(uint64_t key) {
+  return key >> 40;
+}
+
+/**
+ * Key of a PDR from the masked values and masks of its src_iface, teid and
+ * dst_ip fields (network order). PdrLookup and SessionFilter both key PDRs
+ * this way, so that the filter passes whatever pdrLookup may match.
+ */
+static inline uint64_t PdrKeyOf(uint8_t iface, uint8_t iface_mask,
+                                uint32_t teid, uint32_t teid_mask,
+                                uint32_t dst_ip, uint32_t dst_ip_mask) {
+  if (iface_mask != 0xFF)
+    return MakePdrKey(ANY_KEY, 0, 0);
+  if (teid_mask == kNoTeid && teid != kNoTeid)
+    return MakePdrKey(TEID_KEY, iface, teid);
+  if (dst_ip_mask == 0xFFFFFFFFu)
+    return MakePdrKey(UE_KEY, iface, dst_ip);
+  return MakePdrKey(WILD_KEY, iface, 0);
+}
+
+/* copies FieldData `fd' to `out' as a `size'-byte field (`be': big endian) */
+static inline bool ExtractField(const bess::pb::FieldData &fd, int size,
+                                bool be, void *out) {
+  uint64_t v = 0;
+
+  if (fd.encoding_case() == bess::pb::FieldData::kValueInt) {
+    if (!uint64_to_bin(&v, fd.value_int(), size, be))
+      return false;
+  } else if (fd.encoding_case() == bess::pb::FieldData::kValueBin) {
+    if (fd.value_bin().size() > (size_t)size)
+      return false;
+    memcpy(&v, fd.value_bin().c_str(), fd.value_bin().size());
+  }
+  memcpy(out, &v, size);
+
+  return true;
+}
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_PDR_KEY_H_
@@ -0,0 +1,99 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_QSBR_H_
+#define BESS_UTILS_QSBR_H_
+/*----------------------------------------------------------------------------------*/
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace bess {
+namespace utils {
+
+/**
+ * Quiescent-state based reclamation for tables that workers read while the
+ * control thread updates them. Workers bracket each batch with Enter() and
+ * Exit(), i.e. one store and one fence per batch, and never wait on anything.
+ * The writer publishes a new version of an object, unlinks the old one (so
+ * that batches entered from then on can't reach it) and Retire()s it. The
+ * old one is freed by a later Reclaim() once every worker that might still
+ * hold it has left its batch. Retire() and Reclaim() must be serialized by
+ * the caller.
+ */
+template <int kMaxWorkers>
+class Qsbr {
+ public:
+  Qsbr() : epoch_(1) {
+    for (int i = 0; i < kMaxWorkers; i++)
+      workers_[i].epoch = kIdle;
+  }
+
+  /* called by worker `wid' before it reads the table */
+  void Enter(int wid) {
+    __atomic_store_n(&workers_[wid].epoch,
+                     __atomic_load_n(&epoch_, __ATOMIC_RELAXED),
+                     __ATOMIC_RELAXED);
+    /* pairs with the fence in Reclaim(): if the writer misses this store,
+     * the reads that follow see whatever it unlinked before */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+  }
+
+  /* called by worker `wid' once it is done with whatever it read */
+  void Exit(int wid) {
+    __atomic_store_n(&workers_[wid].epoch, kIdle, __ATOMIC_RELEASE);
+  }
+
+  /* `free' is called once no worker can see what was unlinked before */
+  void Retire(std::function<void()> free) {
+    uint64_t epoch = __atomic_add_fetch(&epoch_, 1, __ATOMIC_SEQ_CST);
+    retired_.emplace_back(epoch, std::move(free));
+  }
+
+  /* frees what is safe to free, returns the number of objects still held */
+  size_t Reclaim() {
+    uint64_t safe = kIdle;
+
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    for (int i = 0; i < kMaxWorkers; i++) {
+      uint64_t e = __atomic_load_n(&workers_[i].epoch, __ATOMIC_ACQUIRE);
+      if (e < safe)
+        safe = e;
+    }
+
+    size_t kept = 0;
+    for (auto &r : retired_) {
+      if (r.first <= safe)
+        r.second();
+      else
+        retired_[kept++] = std::move(r);
+    }
+    retired_.resize(kept);
+
+    return kept;
+  }
+
+  /* frees everything: only once no worker runs anymore */
+  void Drain() {
+    for (auto &r : retired_)
+      r.second();
+    retired_.clear();
+  }
+
+ private:
+  static const uint64_t kIdle = UINT64_MAX;
+
+  struct alignas(64) WorkerEpoch {
+    uint64_t epoch;
+  };
+
+  WorkerEpoch workers_[kMaxWorkers];
+  uint64_t epoch_;
+  std::vector<std::pair<uint64_t, std::function<void()>>> retired_;
+};
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_QSBR_H_
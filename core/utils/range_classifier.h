@@ -0,0 +1,181 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_RANGE_CLASSIFIER_H_
+#define BESS_UTILS_RANGE_CLASSIFIER_H_
+/*----------------------------------------------------------------------------------*/
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+/* for rte_malloc_socket() */
+#include <rte_malloc.h>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace bess {
+namespace utils {
+
+/**
+ * Bit-vector classifier over rules that match a range of values in each of
+ * up to kMaxDims dimensions. Every dimension is cut into elementary
+ * intervals at the rule boundaries, and every interval keeps a bit vector of
+ * the rules covering it. A lookup finds the interval of each key value (SIMD
+ * compares for short dimensions, binary search for long ones), ANDs their
+ * vectors and returns the first rule left: rules are given in priority
+ * order, so that's the best match. Ranges are matched as such, without
+ * expanding them into prefixes.
+ *
+ * The classifier is immutable and lives in a single allocation; a rule
+ * change means building a new one.
+ */
+class RangeClassifier {
+ public:
+  static const int kMaxDims = 8;
+
+  /* inclusive range of values */
+  struct Range {
+    uint32_t lo;
+    uint32_t hi;
+  };
+
+  /**
+   * Builds the classifier of `num_rules' rules, `ranges[r * num_dims + d]'
+   * being what rule `r' matches in dimension `d'. Returns NULL if out of
+   * memory.
+   */
+  static RangeClassifier *Create(const Range *ranges, uint32_t num_rules,
+                                 int num_dims, int socket) {
+    uint32_t words = (num_rules + 63) / 64;
+    std::vector<uint32_t> bounds[kMaxDims];
+    size_t size = sizeof(RangeClassifier);
+
+    for (int d = 0; d < num_dims; d++) {
+      std::vector<uint32_t> &b = bounds[d];
+      b.push_back(0);
+      for (uint32_t r = 0; r < num_rules; r++) {
+        const Range &range = ranges[r * num_dims + d];
+        b.push_back(range.lo);
+        if (range.hi != UINT32_MAX)
+          b.push_back(range.hi + 1);
+      }
+      std::sort(b.begin(), b.end());
+      b.erase(std::unique(b.begin(), b.end()), b.end());
+      /* one interval: every rule matches any value, skip the dimension */
+      if (b.size() > 1)
+        size += b.size() * (sizeof(uint64_t) * words + sizeof(int32_t));
+    }
+
+    RangeClassifier *c = static_cast<RangeClassifier *>(
+        rte_zmalloc_socket("range_classifier", size, 64, socket));
+    if (c == nullptr)
+      return nullptr;
+    c->num_rules_ = num_rules;
+    c->words_ = words;
+    c->num_dims_ = 0;
+
+    /* bit vectors first (8-byte aligned), bounds after all of them */
+    uint64_t *bits = reinterpret_cast<uint64_t *>(c->mem_);
+    size_t bits_len = 0;
+    for (int d = 0; d < num_dims; d++) {
+      if (bounds[d].size() > 1)
+        bits_len += bounds[d].size() * words;
+    }
+    int32_t *biased = reinterpret_cast<int32_t *>(bits + bits_len);
+
+    for (int d = 0; d < num_dims; d++) {
+      const std::vector<uint32_t> &b = bounds[d];
+      if (b.size() <= 1)
+        continue;
+
+      Dim &dim = c->dims_[c->num_dims_++];
+      dim.dim = d;
+      dim.num_bounds = b.size();
+      dim.bits = bits;
+      dim.bounds = biased;
+      for (size_t i = 0; i < b.size(); i++)
+        biased[i] = Bias(b[i]);
+      for (uint32_t r = 0; r < num_rules; r++) {
+        const Range &range = ranges[r * num_dims + d];
+        size_t i = std::lower_bound(b.begin(), b.end(), range.lo) - b.begin();
+        for (; i < b.size() && b[i] <= range.hi; i++)
+          bits[i * words + r / 64] |= 1ULL << (r % 64);
+      }
+      bits += b.size() * words;
+      biased += b.size();
+    }
+
+    return c;
+  }
+
+  static void Free(RangeClassifier *c) { rte_free(c); }
+
+  /* index of the first rule matching `key' (num_dims values), -1 if none */
+  int Lookup(const uint32_t *key) const {
+    const uint64_t *rows[kMaxDims];
+
+    for (int d = 0; d < num_dims_; d++) {
+      const Dim &dim = dims_[d];
+      uint32_t i = CountLE(dim.bounds, dim.num_bounds, Bias(key[dim.dim]));
+      /* bounds[0] is 0, so i >= 1 */
+      rows[d] = dim.bits + (i - 1) * words_;
+    }
+    for (uint32_t w = 0; w < words_; w++) {
+      uint64_t acc = ~0ULL;
+      for (int d = 0; d < num_dims_ && acc; d++)
+        acc &= rows[d][w];
+      if (acc)
+        return w * 64 + __builtin_ctzll(acc);
+    }
+
+    return -1;
+  }
+
+ private:
+  /* dimensions this short are scanned rather than searched */
+  static const uint32_t kMaxScan = 32;
+
+  struct Dim {
+    int dim;
+    uint32_t num_bounds;
+    const uint64_t *bits;  /* num_bounds vectors of words_ words */
+    const int32_t *bounds; /* ascending, biased */
+  };
+
+  /* unsigned order as signed order, for the SIMD compares */
+  static int32_t Bias(uint32_t v) { return (int32_t)(v ^ 0x80000000u); }
+
+  /* number of `bounds' <= `v' */
+  static uint32_t CountLE(const int32_t *bounds, uint32_t n, int32_t v) {
+    if (n > kMaxScan)
+      return std::upper_bound(bounds, bounds + n, v) - bounds;
+
+    uint32_t i = 0, cnt = 0;
+#ifdef __AVX2__
+    __m256i vv = _mm256_set1_epi32(v);
+    for (; i + 8 <= n; i += 8) {
+      __m256i vb = _mm256_loadu_si256((const __m256i *)(bounds + i));
+      __m256i gt = _mm256_cmpgt_epi32(vb, vv);
+      cnt += 8 - __builtin_popcount(
+                     _mm256_movemask_ps(_mm256_castsi256_ps(gt)));
+    }
+#endif
+    for (; i < n; i++)
+      cnt += bounds[i] <= v;
+
+    return cnt;
+  }
+
+  uint32_t num_rules_;
+  uint32_t words_;
+  int num_dims_;
+  Dim dims_[kMaxDims];
+  alignas(64) uint8_t mem_[0];
+};
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_RANGE_CLASSIFIER_H_
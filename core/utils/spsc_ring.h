@@ -0,0 +1,73 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef BESS_UTILS_SPSC_RING_H_
+#define BESS_UTILS_SPSC_RING_H_
+/*----------------------------------------------------------------------------------*/
+#include <cstdint>
+#include <cstdlib>
+
+namespace bess {
+namespace utils {
+
+/**
+ * Bounded ring of T for one producer and one consumer thread, e.g. a worker
+ * handing entries over to a background thread. Push() and Pop() never block
+ * or lock: each side owns its index and publishes it with a release store,
+ * so an entry is only read once it is fully written, and only overwritten
+ * once it was read. Consumers taking turns must be serialized by the caller.
+ */
+template <typename T>
+class SpscRing {
+ public:
+  /* size is rounded up to a power of 2 */
+  bool Init(uint32_t size) {
+    uint32_t n = 1;
+    while (n < size)
+      n <<= 1;
+    slots_ = (T *)calloc(n, sizeof(T));
+    if (slots_ == nullptr)
+      return false;
+    mask_ = n - 1;
+    head_ = tail_ = 0;
+    return true;
+  }
+
+  void Free() {
+    free(slots_);
+    slots_ = nullptr;
+  }
+
+  /* called by the producer, false if the ring is full */
+  bool Push(const T &v) {
+    uint32_t head = head_;
+    if (head - __atomic_load_n(&tail_, __ATOMIC_ACQUIRE) > mask_)
+      return false;
+    slots_[head & mask_] = v;
+    __atomic_store_n(&head_, head + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+  /* called by the consumer, false if the ring is empty */
+  bool Pop(T *v) {
+    uint32_t tail = tail_;
+    if (tail == __atomic_load_n(&head_, __ATOMIC_ACQUIRE))
+      return false;
+    *v = slots_[tail & mask_];
+    __atomic_store_n(&tail_, tail + 1, __ATOMIC_RELEASE);
+    return true;
+  }
+
+ private:
+  /* each index on its own line, written by one side only */
+  alignas(64) uint32_t head_ = 0;
+  alignas(64) uint32_t tail_ = 0;
+  alignas(64) T *slots_ = nullptr;
+  uint32_t mask_ = 0;
+};
+
+}  // namespace utils
+}  // namespace bess
+/*----------------------------------------------------------------------------------*/
+#endif  // BESS_UTILS_SPSC_RING_H_
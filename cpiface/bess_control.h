@@ -9,10 +9,16 @@
 #include "module_msg.pb.h"
 #include "service.grpc.pb.h"
 #include <glog/logging.h>
+#include <google/protobuf/arena.h>
 #include <grpc++/channel.h>
+#include <grpc++/client_context.h>
+#include <grpc++/completion_queue.h>
 #include <grpc++/create_channel.h>
 /*--------------------------------------------------------------------------------*/
 using namespace grpc;
+using google::protobuf::Arena;
+using google::protobuf::Message;
+using google::protobuf::RepeatedPtrField;
 /*--------------------------------------------------------------------------------*/
 /**
  * BESSD macros
@@ -34,10 +40,12 @@ enum src_iface_type { Access = 1, Core };
 #define PDRADDMETHOD "add"
 #define PDRDELMETHOD "delete"
 #define PDRCLRMETHOD "clear"
+#define PDRADDBULKMETHOD "add_bulk"
 #define FARLOOKUPMOD "farLookup"
 #define FARADDMETHOD "add"
 #define FARDELMETHOD "delete"
 #define FARCLRMETHOD "clear"
+#define FARADDBULKMETHOD "add_bulk"
 #define QOSCOUNTERMOD "QoSCounter"
 #define COUNTERADDMETHOD "add"
 #define COUNTERDELMETHOD "remove"
@@ -95,234 +103,285 @@ struct FARArgs {
 /*--------------------------------------------------------------------------------*/
 class BessClient {
  private:
+  /**
+   * State of one in-flight ModuleCommand RPC. A ClientContext can't be
+   * reused across RPCs, so every command gets its own.
+   */
+  struct AsyncCommand {
+    ClientContext context;
+    bess::pb::CommandResponse cre;
+    Status status;
+    const char *caller;
+    void *op;
+    std::unique_ptr<ClientAsyncResponseReader<bess::pb::CommandResponse>> rpc;
+  };
+
   std::unique_ptr<bess::pb::BESSControl::Stub> stub_;
-  ClientContext context;
-  bess::pb::CommandRequest crt;
-  bess::pb::CommandResponse cre;
+  CompletionQueue cq_;
+  uint32_t inflight_;
+  void *op_;
+
+  /**
+   * The request and the command arguments are built once, on arena_, with
+   * all their FieldData entries in place. The run* functions only overwrite
+   * the scalars in them, so issuing a command allocates nothing but the
+   * RPC state, and the Any/string buffers keep their capacity across calls.
+   */
+  Arena arena_;
+  bess::pb::CommandRequest *crt;
+  bess::pb::WildcardMatchCommandAddArg *wmcaa_;
+  bess::pb::WildcardMatchCommandDeleteArg *wmcda_;
+  bess::pb::ExactMatchCommandAddArg *emcaa_;
+  bess::pb::ExactMatchCommandDeleteArg *emcda_;
+  bess::pb::CounterAddArg *caa_;
+  bess::pb::CounterRemoveArg *cra_;
+  bess::pb::EmptyArg *ea_;
+  bess::pb::WildcardMatchConfig *wmc_;
+  bess::pb::ExactMatchConfig *emc_;
+
+  template <typename T>
+  T *newMessage() {
+    return Arena::CreateMessage<T>(&arena_);
+  }
+
+  static void addFields(RepeatedPtrField<bess::pb::FieldData> *f, int n) {
+    while (n-- > 0)
+      f->Add()->set_value_int(0);
+  }
+
+  /* values, masks and valuesv of the pdrLookup rules */
+  static void newPDRRule(bess::pb::WildcardMatchCommandAddArg *wmcaa) {
+    addFields(wmcaa->mutable_values(), 8);
+    addFields(wmcaa->mutable_masks(), 8);
+    addFields(wmcaa->mutable_valuesv(), 4);
+  }
+
+  /* fields and values of the farLookup rules */
+  static void newFARRule(bess::pb::ExactMatchCommandAddArg *emcaa) {
+    addFields(emcaa->mutable_fields(), 2);
+    addFields(emcaa->mutable_values(), 6);
+  }
+
+  /* point `crt' at `arg' for `cmd' on module `modname' */
+  void setCommand(const char *modname, const char *cmd, const Message &arg) {
+    crt->set_name(modname);
+    crt->set_cmd(cmd);
+    crt->mutable_arg()->PackFrom(arg);
+  }
+
+  /* issue `crt' without waiting for bessd's response */
+  void sendCommand(const char *caller) {
+    AsyncCommand *call = new AsyncCommand();
+    call->caller = caller;
+    call->op = op_;
+    call->rpc = stub_->AsyncModuleCommand(&call->context, *crt, &cq_);
+    call->rpc->Finish(&call->cre, &call->status, (void *)call);
+    inflight_++;
+  }
+
+  /* log the outcome of a finished command and release it */
+  void *reap(AsyncCommand *call, bool ok) {
+    void *op = call->op;
+
+    inflight_--;
+    // Act upon its status.
+    if (ok && call->status.ok()) {
+      VLOG(1) << call->caller << " RPC successfully executed." << std::endl;
+    } else {
+      std::cout << call->status.error_code() << ": "
+                << call->status.error_message() << std::endl;
+      std::cout << call->caller << " RPC failed." << std::endl;
+    }
+    delete call;
+
+    return op;
+  }
 
  public:
+  /**
+   * The stub (and its channel) is meant to be created once per process
+   * and shared by all calls. Commands are pipelined over it and only
+   * waited upon in flush() or complete(). A BessClient is not thread-safe;
+   * every thread issuing commands needs its own.
+   */
   BessClient(std::shared_ptr<Channel> channel)
-      : stub_(bess::pb::BESSControl::NewStub(channel)), crt() {}
+      : stub_(bess::pb::BESSControl::NewStub(channel)),
+        inflight_(0),
+        op_(NULL),
+        crt(newMessage<bess::pb::CommandRequest>()),
+        wmcaa_(newMessage<bess::pb::WildcardMatchCommandAddArg>()),
+        wmcda_(newMessage<bess::pb::WildcardMatchCommandDeleteArg>()),
+        emcaa_(newMessage<bess::pb::ExactMatchCommandAddArg>()),
+        emcda_(newMessage<bess::pb::ExactMatchCommandDeleteArg>()),
+        caa_(newMessage<bess::pb::CounterAddArg>()),
+        cra_(newMessage<bess::pb::CounterRemoveArg>()),
+        ea_(newMessage<bess::pb::EmptyArg>()),
+        wmc_(newMessage<bess::pb::WildcardMatchConfig>()),
+        emc_(newMessage<bess::pb::ExactMatchConfig>()) {
+    newPDRRule(wmcaa_);
+    addFields(wmcda_->mutable_values(), 8);
+    addFields(wmcda_->mutable_masks(), 8);
+    newFARRule(emcaa_);
+    addFields(emcda_->mutable_fields(), 2);
+  }
 
-  void runAddPDRCommand(const void *v, const char *modname) {
-    const PDRArgs *pa = (const PDRArgs *)v;
-    bess::pb::WildcardMatchCommandAddArg *wmcaa =
-        new bess::pb::WildcardMatchCommandAddArg();
+  ~BessClient() {
+    void *tag;
+    bool ok;
+
+    flush();
+    cq_.Shutdown();
+    while (cq_.Next(&tag, &ok))
+      ;
+  }
+
+  /* number of commands issued but not reaped yet */
+  uint32_t inflight() const { return inflight_; }
+
+  /* tag the commands issued from now on with `op' (see complete()) */
+  void setOp(void *op) { op_ = op; }
+
+  /* wait for all the commands issued so far */
+  void flush() {
+    void *tag;
+    bool ok;
+
+    while (inflight_ > 0 && cq_.Next(&tag, &ok))
+      reap((AsyncCommand *)tag, ok);
+  }
+
+  /**
+   * Reap one finished command, waiting until `deadline' at most. Returns
+   * false on timeout, otherwise stores the command's tag in `op'.
+   */
+  bool complete(void **op, std::chrono::system_clock::time_point deadline) {
+    void *tag;
+    bool ok;
+
+    if (inflight_ == 0 ||
+        cq_.AsyncNext(&tag, &ok, deadline) != CompletionQueue::GOT_EVENT)
+      return false;
+    *op = reap((AsyncCommand *)tag, ok);
+
+    return true;
+  }
+
+  /* fills in a pdrLookup rule built by newPDRRule() */
+  static void fillPDRRule(const PDRArgs *pa,
+                          bess::pb::WildcardMatchCommandAddArg *wmcaa) {
     wmcaa->set_gate(pa->need_decap);
     wmcaa->set_priority(1);
 
     /* SET VALUES */
-    /* set src_iface value */
-    bess::pb::FieldData *src_iface = wmcaa->add_values();
-    /* Access = 1, Core = 2 */
-    src_iface->set_value_int(pa->sit);
-
+    /* set src_iface value: Access = 1, Core = 2 */
+    wmcaa->mutable_values(0)->set_value_int(pa->sit);
     /* set tunnel_ipv4_dst */
-    bess::pb::FieldData *tunnel_ipv4_dst = wmcaa->add_values();
-    tunnel_ipv4_dst->set_value_int(pa->tipd);
-
+    wmcaa->mutable_values(1)->set_value_int(pa->tipd);
     /* set teid */
-    bess::pb::FieldData *_teid = wmcaa->add_values();
-    _teid->set_value_int(pa->enb_teid);
-
+    wmcaa->mutable_values(2)->set_value_int(pa->enb_teid);
     /* set src ip */
-    bess::pb::FieldData *src_ip = wmcaa->add_values();
-    src_ip->set_value_int(pa->daddr);
-
+    wmcaa->mutable_values(3)->set_value_int(pa->daddr);
     /* set dst ip */
-    bess::pb::FieldData *dst_ip = wmcaa->add_values();
-    dst_ip->set_value_int(pa->saddr);
-
+    wmcaa->mutable_values(4)->set_value_int(pa->saddr);
     /* set src l4 port */
-    bess::pb::FieldData *l4_srcport = wmcaa->add_values();
-    l4_srcport->set_value_int(pa->dport);
-
+    wmcaa->mutable_values(5)->set_value_int(pa->dport);
     /* set dst l4 port */
-    bess::pb::FieldData *l4_dstport = wmcaa->add_values();
-    l4_dstport->set_value_int(pa->sport);
-
+    wmcaa->mutable_values(6)->set_value_int(pa->sport);
     /* set proto id */
-    bess::pb::FieldData *_protoid = wmcaa->add_values();
-    _protoid->set_value_int(pa->protoid);
+    wmcaa->mutable_values(7)->set_value_int(pa->protoid);
 
     /* SET MASKS */
-    /* set src_iface value */
-    src_iface = wmcaa->add_masks();
-    /* Access = 0xFF, Core = 0xFF */
-    src_iface->set_value_int(0xFF);
-
+    /* set src_iface value: Access = 0xFF, Core = 0xFF */
+    wmcaa->mutable_masks(0)->set_value_int(0xFF);
     /* set tunnel_ipv4_dst - Setting it to 0 for the time being */
-    tunnel_ipv4_dst = wmcaa->add_masks();
-    tunnel_ipv4_dst->set_value_int(pa->tipd_mask);
-
+    wmcaa->mutable_masks(1)->set_value_int(pa->tipd_mask);
     /* set teid */
-    _teid = wmcaa->add_masks();
-    _teid->set_value_int(pa->enb_teid_mask);
-
+    wmcaa->mutable_masks(2)->set_value_int(pa->enb_teid_mask);
     /* set src ip */
-    src_ip = wmcaa->add_masks();
-    src_ip->set_value_int(pa->daddr_mask);
-
+    wmcaa->mutable_masks(3)->set_value_int(pa->daddr_mask);
     /* set dst ip */
-    dst_ip = wmcaa->add_masks();
-    dst_ip->set_value_int(pa->saddr_mask);
-
+    wmcaa->mutable_masks(4)->set_value_int(pa->saddr_mask);
     /* set src l4 port */
-    l4_srcport = wmcaa->add_masks();
-    l4_srcport->set_value_int(pa->dport_mask);
-
+    wmcaa->mutable_masks(5)->set_value_int(pa->dport_mask);
     /* set dst l4 port */
-    l4_dstport = wmcaa->add_masks();
-    l4_dstport->set_value_int(pa->sport_mask);
-
+    wmcaa->mutable_masks(6)->set_value_int(pa->sport_mask);
     /* set proto id */
-    _protoid = wmcaa->add_masks();
-    _protoid->set_value_int(pa->protoid_mask);
+    wmcaa->mutable_masks(7)->set_value_int(pa->protoid_mask);
 
     /* SET VALUESV */
     /* set pdr_id, set to 0 for the time being */
-    bess::pb::FieldData *_void = wmcaa->add_valuesv();
-    _void->set_value_int(pa->pdr_id);
-
+    wmcaa->mutable_valuesv(0)->set_value_int(pa->pdr_id);
     /* set fseid, set to 0 for the time being */
-    _void = wmcaa->add_valuesv();
-    _void->set_value_int(pa->fseid);
-
+    wmcaa->mutable_valuesv(1)->set_value_int(pa->fseid);
     /* set ctr_id, set to teid for the time being */
-    _void = wmcaa->add_valuesv();
-    _void->set_value_int(pa->ctr_id);
-
+    wmcaa->mutable_valuesv(2)->set_value_int(pa->ctr_id);
     /* set far_id, set to 0 for the time being */
-    _void = wmcaa->add_valuesv();
-    _void->set_value_int(pa->far_id);
-
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*wmcaa);
-    crt.set_name(modname);
-    crt.set_cmd(PDRADDMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runAddPDRCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runAddPDRCommand RPC failed." << std::endl;
-    }
+    wmcaa->mutable_valuesv(3)->set_value_int(pa->far_id);
+  }
 
-    delete wmcaa;
+  void runAddPDRCommand(const void *v, const char *modname) {
+    const PDRArgs *pa = (const PDRArgs *)v;
+    bess::pb::WildcardMatchCommandAddArg *wmcaa = wmcaa_;
 
-    /* `any' freed up by ModuleCommand() */
+    fillPDRRule(pa, wmcaa);
+    setCommand(modname, PDRADDMETHOD, *wmcaa);
+    sendCommand("runAddPDRCommand");
   }
 
   void runDelPDRCommand(const void *v, const char *modname) {
     const PDRArgs *pa = (const PDRArgs *)v;
-    bess::pb::WildcardMatchCommandDeleteArg *wmcda =
-        new bess::pb::WildcardMatchCommandDeleteArg();
+    bess::pb::WildcardMatchCommandDeleteArg *wmcda = wmcda_;
 
     /* SET VALUES */
-    /* set src_iface value */
-    bess::pb::FieldData *src_iface = wmcda->add_values();
-    /* Access = 1, Core = 2 */
-    src_iface->set_value_int(pa->sit);
-
+    /* set src_iface value: Access = 1, Core = 2 */
+    wmcda->mutable_values(0)->set_value_int(pa->sit);
     /* set tunnel_ipv4_dst */
-    bess::pb::FieldData *tunnel_ipv4_dst = wmcda->add_values();
-    tunnel_ipv4_dst->set_value_int(pa->tipd);
-
+    wmcda->mutable_values(1)->set_value_int(pa->tipd);
     /* set teid */
-    bess::pb::FieldData *_teid = wmcda->add_values();
-    _teid->set_value_int(pa->enb_teid);
-
+    wmcda->mutable_values(2)->set_value_int(pa->enb_teid);
     /* set dst ip */
-    bess::pb::FieldData *dst_ip = wmcda->add_values();
-    dst_ip->set_value_int(pa->saddr);
-
+    wmcda->mutable_values(3)->set_value_int(pa->saddr);
     /* set src ip */
-    bess::pb::FieldData *src_ip = wmcda->add_values();
-    src_ip->set_value_int(pa->daddr);
-
+    wmcda->mutable_values(4)->set_value_int(pa->daddr);
     /* set dst l4 port */
-    bess::pb::FieldData *l4_dstport = wmcda->add_values();
-    l4_dstport->set_value_int(pa->sport);
-
+    wmcda->mutable_values(5)->set_value_int(pa->sport);
     /* set src l4 port */
-    bess::pb::FieldData *l4_srcport = wmcda->add_values();
-    l4_srcport->set_value_int(pa->dport);
-
+    wmcda->mutable_values(6)->set_value_int(pa->dport);
     /* set proto id */
-    bess::pb::FieldData *_protoid = wmcda->add_values();
-    _protoid->set_value_int(pa->protoid);
+    wmcda->mutable_values(7)->set_value_int(pa->protoid);
 
     /* SET MASKS */
-    /* set src_iface value */
-    src_iface = wmcda->add_masks();
-    /* Access = 0xFF, Core = 0xFF */
-    src_iface->set_value_int(0xFF);
-
+    /* set src_iface value: Access = 0xFF, Core = 0xFF */
+    wmcda->mutable_masks(0)->set_value_int(0xFF);
     /* set tunnel_ipv4_dst - Setting it to 0 for the time being */
-    tunnel_ipv4_dst = wmcda->add_masks();
-    tunnel_ipv4_dst->set_value_int(pa->tipd_mask);
-
+    wmcda->mutable_masks(1)->set_value_int(pa->tipd_mask);
     /* set teid */
-    _teid = wmcda->add_masks();
-    _teid->set_value_int(pa->enb_teid_mask);
-
+    wmcda->mutable_masks(2)->set_value_int(pa->enb_teid_mask);
     /* set dst ip */
-    dst_ip = wmcda->add_masks();
-    dst_ip->set_value_int(pa->saddr_mask);
-
+    wmcda->mutable_masks(3)->set_value_int(pa->saddr_mask);
     /* set src ip */
-    src_ip = wmcda->add_masks();
-    src_ip->set_value_int(pa->daddr_mask);
-
+    wmcda->mutable_masks(4)->set_value_int(pa->daddr_mask);
     /* set dst l4 port */
-    l4_dstport = wmcda->add_masks();
-    l4_dstport->set_value_int(pa->sport_mask);
-
+    wmcda->mutable_masks(5)->set_value_int(pa->sport_mask);
     /* set src l4 port */
-    l4_srcport = wmcda->add_masks();
-    l4_srcport->set_value_int(pa->sport_mask);
-
+    wmcda->mutable_masks(6)->set_value_int(pa->sport_mask);
     /* set proto id */
-    _protoid = wmcda->add_masks();
-    _protoid->set_value_int(pa->protoid_mask);
-
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*wmcda);
-    crt.set_name(modname);
-    crt.set_cmd(PDRDELMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runDelPDRCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runDelPDRCommand RPC failed." << std::endl;
-    }
-
-    delete wmcda;
+    wmcda->mutable_masks(7)->set_value_int(pa->protoid_mask);
 
-    /* `any' freed up by ModuleCommand() */
+    setCommand(modname, PDRDELMETHOD, *wmcda);
+    sendCommand("runDelPDRCommand");
   }
 
-  void runAddFARCommand(const void *v, const char *modname) {
-    const FARArgs *fa = (const FARArgs *)v;
-    bess::pb::ExactMatchCommandAddArg *emcaa =
-        new bess::pb::ExactMatchCommandAddArg();
+  /* fills in a farLookup rule built by newFARRule() */
+  static void fillFARRule(const FARArgs *fa,
+                          bess::pb::ExactMatchCommandAddArg *emcaa) {
     emcaa->set_gate(fa->tuntype);
 
     /* SET FIELDS */
     /* set far_id value */
-    bess::pb::FieldData *_far_id = emcaa->add_fields();
-    _far_id->set_value_int(fa->far_id);
-
+    emcaa->mutable_fields(0)->set_value_int(fa->far_id);
     /* set fseid */
-    bess::pb::FieldData *_fseid = emcaa->add_fields();
-    _fseid->set_value_int(fa->fseid);
+    emcaa->mutable_fields(1)->set_value_int(fa->fseid);
 
     /* SET VALUES */
     /* set FAR action */
@@ -333,196 +392,98 @@ class BessClient {
       action = action | DO_DROP;
     if (fa->notify_cp)
       action = action | DO_NOTIFY;
-    bess::pb::FieldData *_action = emcaa->add_values();
-    _action->set_value_int(action);
-
+    emcaa->mutable_values(0)->set_value_int(action);
     /* set tuntype */
-    bess::pb::FieldData *_tuntype = emcaa->add_values();
-    _tuntype->set_value_int(fa->tuntype);
-
+    emcaa->mutable_values(1)->set_value_int(fa->tuntype);
     /* set tun_src_ip */
-    bess::pb::FieldData *_tun_src_ip = emcaa->add_values();
-    _tun_src_ip->set_value_int(fa->tun_src_ip);
-
+    emcaa->mutable_values(2)->set_value_int(fa->tun_src_ip);
     /* set tun_dst_ip */
-    bess::pb::FieldData *_tun_dst_ip = emcaa->add_values();
-    _tun_dst_ip->set_value_int(fa->tun_dst_ip);
-
+    emcaa->mutable_values(3)->set_value_int(fa->tun_dst_ip);
     /* set teid */
-    bess::pb::FieldData *_teid = emcaa->add_values();
-    _teid->set_value_int(fa->teid);
-
+    emcaa->mutable_values(4)->set_value_int(fa->teid);
     /* set tun_port */
-    bess::pb::FieldData *_tun_port = emcaa->add_values();
-    _tun_port->set_value_int(fa->tun_port);
-
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*emcaa);
-    crt.set_name(modname);
-    crt.set_cmd(FARADDMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runAddFARCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runAddFARCommand RPC failed." << std::endl;
-    }
+    emcaa->mutable_values(5)->set_value_int(fa->tun_port);
+  }
 
-    delete emcaa;
+  void runAddFARCommand(const void *v, const char *modname) {
+    const FARArgs *fa = (const FARArgs *)v;
+    bess::pb::ExactMatchCommandAddArg *emcaa = emcaa_;
 
-    /* `any' freed up by ModuleCommand() */
+    fillFARRule(fa, emcaa);
+    setCommand(modname, FARADDMETHOD, *emcaa);
+    sendCommand("runAddFARCommand");
   }
 
   void runDelFARCommand(const void *v, const char *modname) {
     const FARArgs *fa = (const FARArgs *)v;
-    bess::pb::ExactMatchCommandDeleteArg *emcda =
-        new bess::pb::ExactMatchCommandDeleteArg();
+    bess::pb::ExactMatchCommandDeleteArg *emcda = emcda_;
 
     /* SET FIELDS */
     /* set far_id value */
-    bess::pb::FieldData *_far_id = emcda->add_fields();
-    _far_id->set_value_int(fa->far_id);
-
+    emcda->mutable_fields(0)->set_value_int(fa->far_id);
     /* set fseid */
-    bess::pb::FieldData *_fseid = emcda->add_fields();
-    _fseid->set_value_int(fa->fseid);
-
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*emcda);
-    crt.set_name(modname);
-    crt.set_cmd(FARDELMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runDelFARCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runDelFARCommand RPC failed." << std::endl;
-    }
+    emcda->mutable_fields(1)->set_value_int(fa->fseid);
 
-    delete emcda;
-
-    /* `any' freed up by ModuleCommand() */
+    setCommand(modname, FARDELMETHOD, *emcda);
+    sendCommand("runDelFARCommand");
   }
 
   void runAddCounterCommand(const void *v, const char *modname) {
     const uint32_t ctr_id = *((const uint32_t *)v);
-    bess::pb::CounterAddArg *caa = new bess::pb::CounterAddArg();
-    caa->set_ctr_id(ctr_id);
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*caa);
-    crt.set_name(modname);
-    crt.set_cmd(COUNTERADDMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runAddCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runAddCommand RPC failed." << std::endl;
-    }
-
-    delete caa;
-
-    /* `any' freed up by ModuleCommand() */
+    caa_->set_ctr_id(ctr_id);
+    setCommand(modname, COUNTERADDMETHOD, *caa_);
+    sendCommand("runAddCounterCommand");
   }
 
   void runDelCounterCommand(const void *v, const char *modname) {
     const uint32_t ctr_id = *((const uint32_t *)v);
-    bess::pb::CounterRemoveArg *cra = new bess::pb::CounterRemoveArg();
-    cra->set_ctr_id(ctr_id);
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*cra);
-    crt.set_name(modname);
-    crt.set_cmd(COUNTERDELMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runAddCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runAddCommand RPC failed." << std::endl;
-    }
-
-    delete cra;
-
-    /* `any' freed up by ModuleCommand() */
+    cra_->set_ctr_id(ctr_id);
+    setCommand(modname, COUNTERDELMETHOD, *cra_);
+    sendCommand("runDelCounterCommand");
   }
 
   void runClrPDRsCommand(const void *v, const char *modname) {
-    bess::pb::EmptyArg *ea = new bess::pb::EmptyArg();
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*ea);
-    crt.set_name(modname);
-    crt.set_cmd(PDRCLRMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runClrPDRsCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runClrPDRsCommand RPC failed." << std::endl;
-    }
-
-    delete ea;
-
-    /* `any' freed up by ModuleCommand() */
+    setCommand(modname, PDRCLRMETHOD, *ea_);
+    sendCommand("runClrPDRsCommand");
   }
 
   void runClrFARsCommand(const void *v, const char *modname) {
-    bess::pb::EmptyArg *ea = new bess::pb::EmptyArg();
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*ea);
-    crt.set_name(modname);
-    crt.set_cmd(FARCLRMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runClrFARsCommand RPC successfully executed." << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runClrFARsCommand RPC failed." << std::endl;
-    }
-
-    delete ea;
-
-    /* `any' freed up by ModuleCommand() */
+    setCommand(modname, FARCLRMETHOD, *ea_);
+    sendCommand("runClrFARsCommand");
   }
 
   void runClrCountersCommand(const void *v, const char *modname) {
-    bess::pb::EmptyArg *ea = new bess::pb::EmptyArg();
-    ::google::protobuf::Any *any = new ::google::protobuf::Any();
-    any->PackFrom(*ea);
-    crt.set_name(modname);
-    crt.set_cmd(COUNTERCLRMETHOD);
-    crt.set_allocated_arg(any);
-    Status status = stub_->ModuleCommand(&context, crt, &cre);
-    // Act upon its status.
-    if (status.ok()) {
-      VLOG(1) << "runClrCountersCommand RPC successfully executed."
-              << std::endl;
-    } else {
-      std::cout << status.error_code() << ": " << status.error_message()
-                << std::endl;
-      std::cout << "runClrCountersCommand RPC failed." << std::endl;
-    }
+    setCommand(modname, COUNTERCLRMETHOD, *ea_);
+    sendCommand("runClrCountersCommand");
+  }
 
-    delete ea;
+  /**
+   * Adds all of `pas' (`fas') with a single add_bulk command. Used to
+   * re-program bessd in one go, e.g. on a warm restart.
+   */
+  void runAddPDRsCommand(const std::vector<PDRArgs> &pas, const char *modname) {
+    wmc_->clear_rules();
+    for (const PDRArgs &pa : pas) {
+      bess::pb::WildcardMatchCommandAddArg *wmcaa = wmc_->add_rules();
+      /* cleared rules are recycled by add_rules(), with their fields gone */
+      if (wmcaa->values_size() == 0)
+        newPDRRule(wmcaa);
+      fillPDRRule(&pa, wmcaa);
+    }
+    setCommand(modname, PDRADDBULKMETHOD, *wmc_);
+    sendCommand("runAddPDRsCommand");
+  }
 
-    /* `any' freed up by ModuleCommand() */
+  void runAddFARsCommand(const std::vector<FARArgs> &fas, const char *modname) {
+    emc_->clear_rules();
+    for (const FARArgs &fa : fas) {
+      bess::pb::ExactMatchCommandAddArg *emcaa = emc_->add_rules();
+      if (emcaa->fields_size() == 0)
+        newFARRule(emcaa);
+      fillFARRule(&fa, emcaa);
+    }
+    setCommand(modname, FARADDBULKMETHOD, *emc_);
+    sendCommand("runAddFARsCommand");
   }
 
   void (BessClient::*grpc_ptr[GRPC_COUNT])(const void *args,
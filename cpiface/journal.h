@@ -0,0 +1,150 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+/*--------------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+/* for mmap */
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+/*--------------------------------------------------------------------------------*/
+enum { JOURNAL_NONE = 0, JOURNAL_SET = 0x53455421, JOURNAL_DEL = 0x44454c21 };
+
+/**
+ * One session update. A SET record carries the whole session state, so the
+ * last SET (not followed by a DEL) of a UE is all that's needed to restore
+ * it. The counter allocator is not journaled on its own: the ctr_ids of the
+ * live sessions are exactly the ones in use.
+ */
+struct JournalRecord {
+  uint32_t op;
+  uint32_t ue_addr;
+  uint32_t enb_addr;
+  uint32_t teid;
+  uint32_t ctr_id;
+};
+
+/**
+ * Append-only session journal backed by a memory-mapped file. Appending is a
+ * plain memory copy, and the pages outlive the process, so whatever was
+ * appended before a crash or a restart is there when the file is replayed.
+ * The file is zero-filled up front; replay stops at the first empty record.
+ * When it fills up, checkpoint() rewrites it with just the live sessions.
+ * Not thread-safe.
+ */
+class SessJournal {
+ private:
+  std::string path_;
+  uint64_t capacity_;
+  uint64_t next_;
+  JournalRecord *records_;
+
+  static JournalRecord *map(const std::string &path, uint64_t capacity,
+                            bool create) {
+    size_t len = capacity * sizeof(JournalRecord);
+    int fd = open(path.c_str(), create ? O_RDWR | O_CREAT | O_TRUNC : O_RDWR,
+                  0644);
+
+    if (fd == -1)
+      return NULL;
+    if (create && ftruncate(fd, len) == -1) {
+      std::cerr << "Failed to size journal " << path << ": " << strerror(errno)
+                << std::endl;
+      close(fd);
+      return NULL;
+    }
+    void *p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    return p == MAP_FAILED ? NULL : (JournalRecord *)p;
+  }
+
+ public:
+  /**
+   * Journal of `capacity' records at `path'. The file is left alone (it may
+   * still need to be replayed) until the first checkpoint() creates it.
+   */
+  SessJournal(const std::string &path, uint64_t capacity)
+      : path_(path), capacity_(capacity), next_(0), records_(NULL) {}
+
+  ~SessJournal() {
+    if (records_ != NULL)
+      munmap(records_, capacity_ * sizeof(JournalRecord));
+  }
+
+  /* appends `r', false if the journal is full (or not created) */
+  bool append(const JournalRecord &r) {
+    if (records_ == NULL || next_ >= capacity_)
+      return false;
+
+    JournalRecord *slot = &records_[next_++];
+    memcpy(&slot->ue_addr, &r.ue_addr,
+           sizeof(JournalRecord) - offsetof(JournalRecord, ue_addr));
+    /* op last, so that a torn record reads as the end of the journal */
+    __atomic_store_n(&slot->op, r.op, __ATOMIC_RELEASE);
+
+    return true;
+  }
+
+  /**
+   * Replaces the journal with the records fed by `fill' (called with an
+   * append function). The new file is written aside and renamed over the
+   * old one, so a crash half-way leaves the previous journal intact.
+   */
+  template <typename F>
+  bool checkpoint(F fill) {
+    std::string tmp = path_ + ".tmp";
+    JournalRecord *old = records_;
+
+    records_ = map(tmp, capacity_, true);
+    if (records_ == NULL) {
+      std::cerr << "Failed to create journal " << tmp << ": "
+                << strerror(errno) << std::endl;
+      records_ = old;
+      return false;
+    }
+    next_ = 0;
+    fill([this](const JournalRecord &r) { return append(r); });
+    msync(records_, capacity_ * sizeof(JournalRecord), MS_SYNC);
+    if (rename(tmp.c_str(), path_.c_str()) == -1) {
+      std::cerr << "Failed to checkpoint journal " << path_ << ": "
+                << strerror(errno) << std::endl;
+    }
+    if (old != NULL)
+      munmap(old, capacity_ * sizeof(JournalRecord));
+
+    return true;
+  }
+
+  /* calls f(record) for every record of the journal file at `path' */
+  template <typename F>
+  static bool replay(const std::string &path, F f) {
+    struct stat st;
+
+    if (stat(path.c_str(), &st) == -1)
+      return false;
+
+    uint64_t capacity = st.st_size / sizeof(JournalRecord);
+    if (capacity == 0)
+      return true;
+    JournalRecord *records = map(path, capacity, false);
+    if (records == NULL)
+      return false;
+    for (uint64_t i = 0; i < capacity && records[i].op != JOURNAL_NONE; i++)
+      f(records[i]);
+    munmap(records, capacity * sizeof(JournalRecord));
+
+    return true;
+  }
+};
+/*--------------------------------------------------------------------------------*/
+#endif /* !__JOURNAL_H__ */
@@ -27,6 +27,8 @@
 #define SCRIPT_NAME "/tmp/conf/upf.json"
 #define COUNTER_LIMIT 50000
 #define FILENAME_LEN 1024
+#define NUM_WORKERS 4
+#define MAX_INFLIGHT 256
 /*--------------------------------------------------------------------------------*/
 struct Args {
   char bessd_ip[HOSTNAME_LEN] = BESSD_IP;
@@ -38,6 +40,10 @@ struct Args {
   uint16_t zmqd_recv_port = ZMQ_RECV_PORT;
   uint16_t zmqd_nb_port = ZMQ_NB_PORT;
   uint32_t counter_count = COUNTER_LIMIT;
+  uint32_t num_workers = NUM_WORKERS;
+  uint32_t max_inflight = MAX_INFLIGHT;
+  /* session journal path prefix, no warm restart if empty */
+  char journal[FILENAME_LEN] = "";
   char pdrlookup[MODULE_NAME_LEN] = PDRLOOKUPMOD;
   char farlookup[MODULE_NAME_LEN] = FARLOOKUPMOD;
   char qoscounter[MODULE_NAME_LEN] = QOSCOUNTERMOD;
@@ -66,13 +72,16 @@ struct Args {
         {"qoscounter", required_argument, NULL, 'c'},
         {"hostname", required_argument, NULL, 'h'},
         {"json_config", required_argument, NULL, 'f'},
+        {"workers", required_argument, NULL, 'w'},
+        {"max_inflight", required_argument, NULL, 'i'},
+        {"journal", required_argument, NULL, 'j'},
         {0, 0, 0, 0}};
     do {
       int option_index = 0;
       uint32_t val = 0;
 
-      c = getopt_long(argc, argv, "B:b:Z:s:r:c:P:F:N:n:u:h:f:", long_options,
-                      &option_index);
+      c = getopt_long(argc, argv, "B:b:Z:s:r:c:P:F:N:n:u:h:f:w:i:j:",
+                      long_options, &option_index);
 
       if (c == -1)
         break;
@@ -137,6 +146,25 @@ struct Args {
         case 'h':
           strncpy(rmb.hostname, optarg, MIN(strlen(optarg), HOSTNAME_LEN - 1));
           break;
+        case 'w':
+          val = strtoul(optarg, NULL, 10);
+          if (val == 0 || (val == ULONG_MAX && errno == ERANGE)) {
+            std::cerr << "Failed to parse workers" << std::endl;
+            exit(EXIT_FAILURE);
+          }
+          num_workers = val;
+          break;
+        case 'i':
+          val = strtoul(optarg, NULL, 10);
+          if (val == 0 || (val == ULONG_MAX && errno == ERANGE)) {
+            std::cerr << "Failed to parse max_inflight" << std::endl;
+            exit(EXIT_FAILURE);
+          }
+          max_inflight = val;
+          break;
+        case 'j':
+          strncpy(journal, optarg, MIN(strlen(optarg), FILENAME_LEN - 1));
+          break;
         default:
           std::cerr << "Unknown argument - " << argv[optind] << std::endl;
           exit(EXIT_FAILURE);
@@ -0,0 +1,54 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef __RING_H__
+#define __RING_H__
+/*--------------------------------------------------------------------------------*/
+#include <atomic>
+#include <cstdint>
+#include <vector>
+/*--------------------------------------------------------------------------------*/
+/**
+ * Bounded lock-free ring for exactly one producer and one consumer thread.
+ * size needs to be a power of 2.
+ */
+template <typename T>
+class SPSCRing {
+ private:
+  const uint32_t mask_;
+  std::vector<T> slots_;
+  /* producer and consumer indices live on separate cache lines */
+  alignas(64) std::atomic<uint32_t> head_;
+  alignas(64) std::atomic<uint32_t> tail_;
+
+ public:
+  explicit SPSCRing(uint32_t size)
+      : mask_(size - 1), slots_(size), head_(0), tail_(0) {}
+
+  /* returns false if the ring is full */
+  bool push(const T &v) {
+    uint32_t head = head_.load(std::memory_order_relaxed);
+
+    if (head - tail_.load(std::memory_order_acquire) > mask_)
+      return false;
+    slots_[head & mask_] = v;
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  /* returns false if the ring is empty */
+  bool pop(T &v) {
+    uint32_t tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail == head_.load(std::memory_order_acquire))
+      return false;
+    v = slots_[tail & mask_];
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+};
+/*--------------------------------------------------------------------------------*/
+#endif /* !__RING_H__ */
@@ -0,0 +1,204 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+#ifndef __SESS_TABLE_H__
+#define __SESS_TABLE_H__
+/*--------------------------------------------------------------------------------*/
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+/*--------------------------------------------------------------------------------*/
+/**
+ * Open-addressing (linear probing) hash map keyed by a 64-bit session ID.
+ * Slots live in one flat array, so lookups touch a single cache line most of
+ * the time and inserts don't allocate until the table has to grow. Erase
+ * shifts the following entries back instead of leaving tombstones. Not
+ * thread-safe.
+ */
+template <typename V>
+class FlatMap {
+ private:
+  struct Slot {
+    uint64_t key;
+    V val;
+    bool used;
+  };
+
+  std::vector<Slot> slots_;
+  uint64_t mask_;
+  uint64_t size_;
+
+  /* SESS_ID()s only differ in a few bits, mix them all into the low ones */
+  static uint64_t hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return key;
+  }
+
+  /* slot holding `key', or the empty one it would go into */
+  uint64_t lookup(uint64_t key) const {
+    uint64_t i = hash(key) & mask_;
+
+    while (slots_[i].used && slots_[i].key != key)
+      i = (i + 1) & mask_;
+
+    return i;
+  }
+
+  void grow() {
+    std::vector<Slot> old(slots_.size() * 2);
+
+    old.swap(slots_);
+    mask_ = slots_.size() - 1;
+    for (const Slot &s : old) {
+      if (s.used)
+        slots_[lookup(s.key)] = s;
+    }
+  }
+
+ public:
+  explicit FlatMap(uint64_t capacity = 1024) : mask_(0), size_(0) {
+    reserve(capacity);
+  }
+
+  /* make room for `n' entries (kept at most 3/4 full) */
+  void reserve(uint64_t n) {
+    uint64_t slots = 16;
+
+    while (slots * 3 / 4 < n)
+      slots <<= 1;
+    if (slots <= slots_.size())
+      return;
+    if (size_ == 0) {
+      slots_.assign(slots, Slot());
+      mask_ = slots - 1;
+      return;
+    }
+    while (slots_.size() < slots)
+      grow();
+  }
+
+  uint64_t size() const { return size_; }
+
+  V *find(uint64_t key) {
+    uint64_t i = lookup(key);
+
+    return slots_[i].used ? &slots_[i].val : NULL;
+  }
+
+  /**
+   * Returns the value for `key', inserting a value-initialized one if it
+   * isn't there yet. The bool is true if it got inserted.
+   */
+  std::pair<V *, bool> insert(uint64_t key) {
+    if ((size_ + 1) * 4 > slots_.size() * 3)
+      grow();
+
+    uint64_t i = lookup(key);
+    if (slots_[i].used)
+      return std::make_pair(&slots_[i].val, false);
+
+    slots_[i].key = key;
+    slots_[i].val = V();
+    slots_[i].used = true;
+    size_++;
+
+    return std::make_pair(&slots_[i].val, true);
+  }
+
+  /* removes `key', copying its value to `val' first. false if not found */
+  bool erase(uint64_t key, V *val) {
+    uint64_t i = lookup(key);
+
+    if (!slots_[i].used)
+      return false;
+    if (val != NULL)
+      *val = slots_[i].val;
+
+    /* pull back the entries of the probe chain that follows */
+    for (uint64_t j = (i + 1) & mask_; slots_[j].used; j = (j + 1) & mask_) {
+      uint64_t home = hash(slots_[j].key) & mask_;
+      /* keep slots_[j] if its home is cyclically in (i, j] */
+      if (((j - home) & mask_) < ((j - i) & mask_))
+        continue;
+      slots_[i] = slots_[j];
+      i = j;
+    }
+    slots_[i].used = false;
+    size_--;
+
+    return true;
+  }
+
+  /* calls f(key, value) for every entry */
+  template <typename F>
+  void forEach(F f) const {
+    for (const Slot &s : slots_) {
+      if (s.used)
+        f(s.key, s.val);
+    }
+  }
+};
+/*--------------------------------------------------------------------------------*/
+/**
+ * Allocator of IDs in [0, count). IDs never handed out are tracked by a
+ * high-water mark and freed ones go on a LIFO free list, so both operations
+ * are O(1) and nothing has to be filled in up front. Not thread-safe.
+ */
+class IdAllocator {
+ private:
+  uint32_t count_;
+  uint32_t next_;
+  std::vector<uint32_t> free_;
+
+ public:
+  explicit IdAllocator(uint32_t count = 0) : count_(count), next_(0) {}
+
+  void init(uint32_t count) {
+    count_ = count;
+    next_ = 0;
+    free_.clear();
+  }
+
+  /* returns false if all the IDs are in use */
+  bool alloc(uint32_t *id) {
+    if (!free_.empty()) {
+      *id = free_.back();
+      free_.pop_back();
+      return true;
+    }
+    if (next_ >= count_)
+      return false;
+    *id = next_++;
+
+    return true;
+  }
+
+  void free(uint32_t id) { free_.push_back(id); }
+
+  /* marks exactly the IDs in `used' as allocated (e.g. after a restart) */
+  void restore(const std::vector<uint32_t> &used) {
+    std::vector<bool> taken;
+
+    for (uint32_t id : used) {
+      if (id >= taken.size())
+        taken.resize(id + 1);
+      taken[id] = true;
+    }
+    next_ = taken.size();
+    free_.clear();
+    for (uint32_t id = next_; id-- > 0;) {
+      if (!taken[id])
+        free_.push_back(id);
+    }
+  }
+
+  uint32_t inUse() const { return next_ - free_.size(); }
+};
+/*--------------------------------------------------------------------------------*/
+#endif /* !__SESS_TABLE_H__ */
@@ -0,0 +1,354 @@
+/*
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright 2021-present Open Networking Foundation
+ */
+
+/**
+ * Session churn benchmark for zmq-cpiface. It stands in for both of its
+ * peers: a fake SPGW-C creates, modifies and deletes sessions over ZMQ, and a
+ * fake bessd accepts (and counts) the resulting gRPC commands. No core
+ * network or dataplane is needed. Reports sessions/sec and the response
+ * latency distribution of every message type.
+ *
+ *   session-bench [-s sessions] [-W window] [-p port_base] [-c cpiface]
+ *                 [-- extra zmq-cpiface args]
+ */
+/* for msgbuf */
+#include "gtp_common.h"
+/* for fake bessd */
+#include "service.grpc.pb.h"
+#include <grpc++/server.h>
+#include <grpc++/server_builder.h>
+#include <grpc++/server_context.h>
+/* for inet_addr */
+#include <arpa/inet.h>
+/* for getopt() */
+#include <getopt.h>
+/* for cpiface child process */
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+/* for libzmq */
+#include <zmq.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+/*--------------------------------------------------------------------------------*/
+#define BENCH_SESSIONS 100000
+#define BENCH_WINDOW 256
+#define BENCH_PORT_BASE 20000
+#define BENCH_CPIFACE "./zmq-cpiface"
+#define BENCH_TIMEOUT 5000  // in msecs
+#define BENCH_UE_IP "16.0.0.1"
+#define BENCH_ENB_IP "11.1.1.129"
+/*--------------------------------------------------------------------------------*/
+int64_t nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+/*--------------------------------------------------------------------------------*/
+/* latency samples of one message type */
+class Histogram {
+ private:
+  std::vector<int64_t> samples_;
+
+ public:
+  void add(int64_t ns) { samples_.push_back(ns); }
+
+  void print(const char *name, int64_t elapsed_ns) {
+    std::cout << std::left << std::setw(10) << name << std::right;
+    if (samples_.empty()) {
+      std::cout << " no responses" << std::endl;
+      return;
+    }
+    std::sort(samples_.begin(), samples_.end());
+    auto pct = [this](double p) {
+      return samples_[(size_t)(p / 100 * (samples_.size() - 1))] / 1000.0;
+    };
+    std::cout << std::fixed << std::setprecision(1) << std::setw(12)
+              << samples_.size() * 1e9 / elapsed_ns << " msg/s"
+              << "  p50 " << pct(50) << "  p90 " << pct(90) << "  p99 "
+              << pct(99) << "  p99.9 " << pct(99.9) << "  max "
+              << samples_.back() / 1000.0 << " usec" << std::endl;
+  }
+};
+/*--------------------------------------------------------------------------------*/
+/**
+ * Fake bessd: accepts every ModuleCommand and records how many of each
+ * (module, cmd) it got, and over what time span.
+ */
+class FakeBessd final : public bess::pb::BESSControl::Service {
+ private:
+  struct Stats {
+    uint64_t calls;
+    int64_t first_ns;
+    int64_t last_ns;
+  };
+  std::mutex lock_;
+  std::map<std::string, Stats> stats_;
+
+ public:
+  grpc::Status ModuleCommand(grpc::ServerContext *,
+                             const bess::pb::CommandRequest *req,
+                             bess::pb::CommandResponse *) override {
+    int64_t now = nowNs();
+    std::lock_guard<std::mutex> lock(lock_);
+    auto it = stats_.emplace(req->name() + " " + req->cmd(),
+                             Stats{0, now, now});
+    it.first->second.calls++;
+    it.first->second.last_ns = now;
+
+    return grpc::Status::OK;
+  }
+
+  void print() {
+    std::lock_guard<std::mutex> lock(lock_);
+    std::cout << "bessd commands:" << std::endl;
+    for (const auto &s : stats_) {
+      int64_t span = s.second.last_ns - s.second.first_ns;
+      std::cout << "  " << std::left << std::setw(28) << s.first << std::right
+                << std::setw(10) << s.second.calls;
+      if (span > 0)
+        std::cout << std::fixed << std::setprecision(1) << std::setw(12)
+                  << s.second.calls * 1e9 / span << " cmd/s";
+      std::cout << std::endl;
+    }
+  }
+};
+/*--------------------------------------------------------------------------------*/
+struct BenchArgs {
+  uint32_t sessions = BENCH_SESSIONS;
+  uint32_t window = BENCH_WINDOW;
+  uint16_t port_base = BENCH_PORT_BASE;
+  std::string cpiface = BENCH_CPIFACE;
+  std::vector<std::string> extra;
+
+  void parse(int argc, char **argv) {
+    int c;
+
+    while ((c = getopt(argc, argv, "s:W:p:c:")) != -1) {
+      switch (c) {
+        case 's':
+          sessions = strtoul(optarg, NULL, 10);
+          break;
+        case 'W':
+          window = strtoul(optarg, NULL, 10);
+          break;
+        case 'p':
+          port_base = strtoul(optarg, NULL, 10);
+          break;
+        case 'c':
+          cpiface = optarg;
+          break;
+        default:
+          std::cerr << "Usage: " << argv[0]
+                    << " [-s sessions] [-W window] [-p port_base]"
+                    << " [-c cpiface] [-- cpiface args]" << std::endl;
+          exit(EXIT_FAILURE);
+      }
+    }
+    for (int i = optind; i < argc; i++)
+      extra.push_back(argv[i]);
+    if (sessions == 0 || window == 0) {
+      std::cerr << "sessions and window must be > 0" << std::endl;
+      exit(EXIT_FAILURE);
+    }
+  }
+};
+/*--------------------------------------------------------------------------------*/
+BenchArgs bargs;
+pid_t cpiface_pid = -1;
+/* ports: +0 bessd gRPC, +1 registration, +2 CP->DP, +3 DP->CP */
+uint16_t grpcPort() { return bargs.port_base; }
+uint16_t regPort() { return bargs.port_base + 1; }
+uint16_t recvPort() { return bargs.port_base + 2; }
+uint16_t sendPort() { return bargs.port_base + 3; }
+
+std::string zmqAddr(uint16_t port) {
+  return "tcp://127.0.0.1:" + std::to_string(port);
+}
+/*--------------------------------------------------------------------------------*/
+void die(const std::string &msg) {
+  std::cerr << msg << std::endl;
+  if (cpiface_pid > 0)
+    kill(cpiface_pid, SIGKILL);
+  exit(EXIT_FAILURE);
+}
+/*--------------------------------------------------------------------------------*/
+/* runs zmq-cpiface pointed at the fakes */
+void startCpiface(const std::string &json) {
+  std::vector<std::string> av = {bargs.cpiface,
+                                 "-B", "127.0.0.1",
+                                 "-b", std::to_string(grpcPort()),
+                                 "-Z", "127.0.0.1",
+                                 "-r", std::to_string(recvPort()),
+                                 "-N", "127.0.0.1",
+                                 "-n", std::to_string(regPort()),
+                                 "-u", "127.0.0.1",
+                                 "-h", "session-bench",
+                                 "-f", json};
+  av.insert(av.end(), bargs.extra.begin(), bargs.extra.end());
+
+  cpiface_pid = fork();
+  if (cpiface_pid == -1)
+    die("Failed to fork: " + std::string(strerror(errno)));
+  if (cpiface_pid == 0) {
+    std::vector<char *> argv;
+    for (auto &a : av)
+      argv.push_back(&a[0]);
+    argv.push_back(NULL);
+    execv(argv[0], argv.data());
+    std::cerr << "Failed to run " << argv[0] << ": " << strerror(errno)
+              << std::endl;
+    _exit(127);
+  }
+}
+/*--------------------------------------------------------------------------------*/
+/* waits up to BENCH_TIMEOUT for a message on `s' */
+bool recvTimed(void *s, void *buf, size_t len) {
+  zmq_pollitem_t item = {s, 0, ZMQ_POLLIN, 0};
+
+  if (zmq_poll(&item, 1, BENCH_TIMEOUT) <= 0)
+    return false;
+
+  return zmq_recv(s, buf, len, 0) != -1;
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Sends one `mtype' request for each of the sessions, keeping at most
+ * bargs.window of them unanswered, and records each one's response time.
+ * Returns how long the whole run took, in nsecs.
+ */
+int64_t runPhase(void *push, void *pull, long mtype, uint64_t *op_id,
+                 Histogram *h) {
+  static struct msgbuf rbuf;
+  struct resp_msgbuf resp;
+  std::vector<int64_t> sent(bargs.sessions);
+  uint64_t first_op = *op_id;
+  uint32_t outstanding = 0;
+  uint32_t next = 0;
+  uint32_t ue_base = ntohl(inet_addr(BENCH_UE_IP));
+  int64_t start = nowNs();
+
+  memset(&rbuf, 0, sizeof(rbuf));
+  rbuf.mtype = mtype;
+  rbuf.dp_id.id = 1;
+  rbuf.sess_entry.ue_addr.iptype = IPTYPE_IPV4;
+  rbuf.sess_entry.ul_s1_info.enb_addr.iptype = IPTYPE_IPV4;
+  rbuf.sess_entry.ul_s1_info.enb_addr.u.ipv4_addr =
+      ntohl(inet_addr(BENCH_ENB_IP));
+
+  while (next < bargs.sessions || outstanding > 0) {
+    if (next < bargs.sessions && outstanding < bargs.window) {
+      uint32_t ue_addr = ue_base + next;
+      rbuf.sess_entry.ue_addr.u.ipv4_addr = ue_addr;
+      rbuf.sess_entry.sess_id = SESS_ID(ue_addr, DEFAULT_BEARER);
+      rbuf.sess_entry.dl_s1_info.enb_teid = next + 1;
+      rbuf.sess_entry.op_id = (*op_id)++;
+      sent[next++] = nowNs();
+      if (zmq_send(push, &rbuf, sizeof(rbuf), 0) == -1)
+        die("Failed to send request: " + std::string(strerror(errno)));
+      outstanding++;
+      continue;
+    }
+
+    if (!recvTimed(pull, &resp, sizeof(resp)))
+      die("zmq-cpiface stopped answering");
+    /* keepalives don't answer anything */
+    if (resp.mtype != DPN_RESPONSE)
+      continue;
+    if (resp.op_id < first_op || resp.op_id >= first_op + bargs.sessions) {
+      std::cerr << "Unexpected response op_id " << resp.op_id << std::endl;
+      continue;
+    }
+    h->add(nowNs() - sent[resp.op_id - first_op]);
+    outstanding--;
+  }
+
+  return nowNs() - start;
+}
+/*--------------------------------------------------------------------------------*/
+int main(int argc, char **argv) {
+  bargs.parse(argc, argv);
+
+  /* fake bessd */
+  FakeBessd bessd;
+  grpc::ServerBuilder builder;
+  builder.AddListeningPort("127.0.0.1:" + std::to_string(grpcPort()),
+                           grpc::InsecureServerCredentials());
+  builder.RegisterService(&bessd);
+  std::unique_ptr<grpc::Server> server(builder.BuildAndStart());
+  if (!server)
+    die("Failed to start fake bessd");
+
+  /* fake SPGW-C */
+  void *ctx = zmq_ctx_new();
+  void *reg = zmq_socket(ctx, ZMQ_REP);
+  void *pull = zmq_socket(ctx, ZMQ_PULL);
+  void *push = zmq_socket(ctx, ZMQ_PUSH);
+  int linger = 0;
+  zmq_setsockopt(push, ZMQ_LINGER, &linger, sizeof(linger));
+  if (zmq_bind(reg, zmqAddr(regPort()).c_str()) != 0 ||
+      zmq_bind(pull, zmqAddr(sendPort()).c_str()) != 0)
+    die("Failed to bind ZMQ ports: " + std::string(strerror(errno)));
+
+  /* every session needs a counter */
+  std::string json = "/tmp/session-bench-" + std::to_string(getpid()) + ".json";
+  std::ofstream(json) << "{\"max_sessions\": " << bargs.sessions
+                      << ", \"cpiface\": {\"nb_dst_ip\": \"127.0.0.1\", "
+                      << "\"hostname\": \"session-bench\"}}" << std::endl;
+  startCpiface(json);
+
+  /* registration: hand out the port we listen for responses on */
+  char rmb[1024];
+  uint16_t port = sendPort();
+  if (!recvTimed(reg, rmb, sizeof(rmb)))
+    die("zmq-cpiface did not register");
+  zmq_send(reg, &port, sizeof(port), 0);
+  if (zmq_connect(push, zmqAddr(recvPort()).c_str()) != 0)
+    die("Failed to connect to zmq-cpiface: " + std::string(strerror(errno)));
+
+  struct {
+    const char *name;
+    long mtype;
+    Histogram h;
+    int64_t ns;
+  } phases[] = {{"create", MSG_SESS_CRE, Histogram(), 0},
+                {"modify", MSG_SESS_MOD, Histogram(), 0},
+                {"delete", MSG_SESS_DEL, Histogram(), 0}};
+  uint64_t op_id = 1;
+  int64_t total = 0;
+
+  for (auto &p : phases) {
+    p.ns = runPhase(push, pull, p.mtype, &op_id, &p.h);
+    total += p.ns;
+  }
+
+  std::cout << bargs.sessions << " sessions, window " << bargs.window
+            << ": " << std::fixed << std::setprecision(1)
+            << bargs.sessions * 1e9 / total << " sessions/s" << std::endl;
+  for (auto &p : phases)
+    p.h.print(p.name, p.ns);
+  bessd.print();
+
+  kill(cpiface_pid, SIGKILL);
+  waitpid(cpiface_pid, NULL, 0);
+  unlink(json.c_str());
+  server->Shutdown();
+  zmq_close(reg);
+  zmq_close(pull);
+  zmq_close(push);
+  zmq_ctx_destroy(ctx);
+
+  return EXIT_SUCCESS;
+}
+/*--------------------------------------------------------------------------------*/
@@ -8,22 +8,29 @@
 /* for parsing */
 #include "parser.h"
 #include <ctime>
-/* for stack iterator */
-#include <iterator>
-/* for session map*/
-#include <map>
-/* for stack */
-#include <stack>
+/* for unique_ptr */
+#include <memory>
+/* for per-worker in-flight session set */
+#include <unordered_set>
+/* for worker/keepalive threads */
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include <sys/types.h>
 /* for exec wait */
 #include <sys/wait.h>
 #include <unistd.h>
 /* for libzmq */
 #include <zmq.h>
-/* for gettimeofday */
-#include <sys/time.h>
 /* for templates */
 #include "template.h"
+/* for worker queues */
+#include "ring.h"
+/* for session map and counter ids */
+#include "sess_table.h"
+/* for warm restart */
+#include "journal.h"
 /*--------------------------------------------------------------------------------*/
 /**
  * ZMQ stuff
@@ -36,10 +43,49 @@ void *context1;
 void *context2;
 #define ZMQ_POLL_TIMEOUT 1000  // in msecs
 #define KEEPALIVE_TIMEOUT 100  // in secs
+#define WORKER_RING_SIZE 1024
+#define WORKER_IDLE_WAIT 100  // in usecs
+#define RESYNC_BATCH 4096     // rules per add_bulk command
 
 struct TeidEntry {
   uint32_t teid;
   uint32_t ctr_id;
+  uint32_t enb_addr;
+};
+
+/**
+ * A session request whose gRPC calls are still in flight. The response is
+ * sent back to CP once all of them have completed.
+ */
+struct PendingOp {
+  struct resp_msgbuf resp;
+  uint64_t sess_key;
+  uint32_t rpcs;
+  /* counter id of a deleted session, freed once its calls are done */
+  bool free_ctr;
+  uint32_t ctr_id;
+  /* DPN responses carry no status: a failed request goes unanswered, for CP
+   * to time it out rather than take the session as created */
+  bool failed;
+};
+
+/**
+ * Session requests are spread over the workers by SESS_ID, so every
+ * session is always handled (in order) by the same worker. Each worker
+ * owns its slice of the session map and a BessClient with its own
+ * completion queue.
+ */
+struct SessionWorker {
+  SPSCRing<struct msgbuf> ring{WORKER_RING_SIZE};
+  BessClient *client;
+  /* key: SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr, DEFAULT_BEARER), val:
+   * enb_teid) */
+  FlatMap<TeidEntry> zmq_sess_map;
+  /* sessions with gRPC calls in flight */
+  std::unordered_set<uint64_t> busy;
+  /* journal of zmq_sess_map, NULL if warm restart is off */
+  SessJournal *journal;
+  std::thread thread;
 };
 /*--------------------------------------------------------------------------------*/
 void sig_handler(int signo) {
@@ -84,40 +130,489 @@ void force_restart(int argc, char **argv) {
   }
 }
 /*--------------------------------------------------------------------------------*/
-void invokeGRPCall(Args args, void *func_args, const char *modname,
+Args args;
+std::vector<SessionWorker *> workers;
+/* counter ids are shared by all the workers */
+IdAllocator counter;
+std::mutex counter_lock;
+/* zmq sockets aren't thread-safe */
+std::mutex sender_lock;
+// set my_dp_id to 0, SPGW-C will give me the id
+std::atomic<uint32_t> my_dp_id(0);
+/* time (in msecs) of the last message received from CP */
+std::atomic<int64_t> last_ack;
+/* set by keepaliveLoop() once CP is gone, the main thread restarts the DP */
+std::atomic<bool> restart_dp(false);
+/* set by the main thread: workers exit once their ring and calls are done */
+std::atomic<bool> draining(false);
+/*--------------------------------------------------------------------------------*/
+int64_t nowMs() {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Issues the command without waiting for its completion. Call flushGRPCalls()
+ * to wait for all the commands issued so far.
+ */
+void invokeGRPCall(BessClient *b, void *func_args, const char *modname,
                    uint8_t funcID) {
-  BessClient b(CreateChannel(
+  ((*b).*(b->grpc_ptr[funcID]))(func_args, modname);
+}
+/*--------------------------------------------------------------------------------*/
+void flushGRPCalls(BessClient *b) { b->flush(); }
+/*--------------------------------------------------------------------------------*/
+void clearTables(BessClient *b) {
+  invokeGRPCall(b, NULL, args.pdrlookup, GRPC_PDR_CLR);
+  invokeGRPCall(b, NULL, args.farlookup, GRPC_FAR_CLR);
+  invokeGRPCall(b, NULL, (("pre" + std::string(args.qoscounter)).c_str()),
+                GRPC_CTR_CLR);
+  invokeGRPCall(b, NULL, (("postUL" + std::string(args.qoscounter)).c_str()),
+                GRPC_CTR_CLR);
+  invokeGRPCall(b, NULL, (("postDL" + std::string(args.qoscounter)).c_str()),
+                GRPC_CTR_CLR);
+  flushGRPCalls(b);
+}
+/*--------------------------------------------------------------------------------*/
+/* sets the per-session fields of the PDR/FAR templates */
+void setSessionRules(PDRArgs *pd, PDRArgs *pu, FARArgs *fd, FARArgs *fu,
+                     uint32_t ue_addr, uint32_t teid, uint32_t ctr_id,
+                     uint32_t enb_addr) {
+  pd->saddr = ue_addr; /* ueaddr ip */
+  pd->fseid = teid;    /* fseid */
+  pd->ctr_id = ctr_id; /* ctr_id */
+
+  pu->daddr = ue_addr; /* ueaddr ip */
+  pu->fseid = teid;    /* fseid */
+  pu->ctr_id = ctr_id; /* ctr_id */
+
+  fd->fseid = teid; /* fseid */
+  /* n3 addr */
+  fd->tun_src_ip = ntohl((uint32_t)(inet_addr(args.s1u_sgw_ip)));
+  fd->tun_dst_ip = enb_addr; /* enb addr */
+  fd->teid = teid;           /* enb_teid */
+
+  fu->fseid = teid; /* fseid */
+}
+/*--------------------------------------------------------------------------------*/
+std::string journalPath(uint32_t idx) {
+  return std::string(args.journal) + "." + std::to_string(idx);
+}
+/*--------------------------------------------------------------------------------*/
+/* rewrites the worker's journal with only its live sessions */
+void checkpointJournal(SessionWorker *w) {
+  bool ok = w->journal->checkpoint([w](auto append) {
+    w->zmq_sess_map.forEach([&](uint64_t key, const TeidEntry &te) {
+      JournalRecord r = {JOURNAL_SET, (uint32_t)UE_ADDR(key), te.enb_addr,
+                         te.teid, te.ctr_id};
+      append(r);
+    });
+  });
+  if (!ok)
+    std::cerr << "Failed to checkpoint session journal!" << std::endl;
+}
+/*--------------------------------------------------------------------------------*/
+/* records the current state of a session (NULL: deleted) in the journal */
+void journalSession(SessionWorker *w, uint64_t key, const TeidEntry *te) {
+  JournalRecord r = {JOURNAL_DEL, (uint32_t)UE_ADDR(key), 0, 0, 0};
+
+  if (w->journal == NULL)
+    return;
+  if (te != NULL) {
+    r.op = JOURNAL_SET;
+    r.enb_addr = te->enb_addr;
+    r.teid = te->teid;
+    r.ctr_id = te->ctr_id;
+  }
+  /* when full, the map (already updated) is all the journal needs */
+  if (!w->journal->append(r))
+    checkpointJournal(w);
+}
+/*--------------------------------------------------------------------------------*/
+BessClient *newBessClient() {
+  /* every client gets its own channel (and connection) to bessd */
+  ChannelArguments ch_args;
+  ch_args.SetInt(GRPC_ARG_USE_LOCAL_SUBCHANNEL_POOL, 1);
+  return new BessClient(CreateCustomChannel(
       std::string(args.bessd_ip) + ":" + std::to_string(args.bessd_port),
-      InsecureChannelCredentials()));
-  ((b).*(b.grpc_ptr[funcID]))(func_args, modname);
+      InsecureChannelCredentials(), ch_args));
+}
+/*--------------------------------------------------------------------------------*/
+void sendResponse(struct resp_msgbuf *resp) {
+  std::lock_guard<std::mutex> lock(sender_lock);
+  int size = zmq_send(sender, resp, sizeof(*resp), ZMQ_NOBLOCK);
+  if (size == -1)
+    std::cerr << "Error in zmq sending: " << strerror(errno) << std::endl;
+  else
+    VLOG(1) << "Sending back response block" << std::endl;
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Handles one session request: updates the worker's session map and issues
+ * the PDR/FAR/counter updates to bessd. Returns the number of gRPC calls
+ * issued, `op' is completed once they are done.
+ */
+uint32_t processMsg(SessionWorker *w, struct msgbuf &rbuf, PendingOp *op) {
+  struct resp_msgbuf &resp = op->resp;
+  BessClient *b = w->client;
+  uint32_t inflight = b->inflight();
+  uint64_t key = SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr, DEFAULT_BEARER);
+  std::pair<TeidEntry *, bool> ins;
+  TeidEntry *te;
+  uint32_t enb_teid = 0;
+  uint32_t curr_ctr = 0;
+  FARArgs fa;
+
+  memset(&resp, 0, sizeof(struct resp_msgbuf));
+  resp.op_id = rbuf.sess_entry.op_id;
+  resp.dp_id.id = rbuf.dp_id.id;
+  resp.mtype = DPN_RESPONSE;
+  resp.sess_id = rbuf.sess_entry.sess_id;
+
+  VLOG(1) << "UEADDR: " << rbuf.sess_entry.ue_addr
+          << ", ENODEADDR: " << rbuf.sess_entry.ul_s1_info.enb_addr
+          << ", sgw_teid: " << (rbuf.sess_entry.ul_s1_info.sgw_teid)
+          << ", enb_teid: " << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid)
+          << " (" << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << ")"
+          << std::endl;
+
+  switch (rbuf.mtype) {
+    case MSG_SESS_CRE:
+      VLOG(1) << "Got a session create request" << std::endl;
+      // SPGW-C returns the DP ID
+      my_dp_id = rbuf.dp_id.id;
+      ins = w->zmq_sess_map.insert(key);
+      te = ins.first;
+      te->teid = 0;
+      te->enb_addr = 0;
+      /* a re-created session keeps its counter */
+      if (ins.second) {
+        std::lock_guard<std::mutex> lock(counter_lock);
+        if (!counter.alloc(&te->ctr_id)) {
+          std::cerr << "Out of counters!" << std::endl;
+          w->zmq_sess_map.erase(key, NULL);
+          op->failed = true;
+          break;
+        }
+      }
+      journalSession(w, key, te);
+      VLOG(1) << "Assigning sess with IP addr: "
+              << rbuf.sess_entry.ue_addr.u.ipv4_addr
+              << " counter: " << te->ctr_id << std::endl;
+      break;
+    case MSG_SESS_MOD:
+      VLOG(1) << "Got a session modify request" << std::endl;
+      te = w->zmq_sess_map.find(key);
+      if (te == NULL) {
+        std::cerr << "No record found!" << std::endl;
+        break;
+      }
+      curr_ctr = te->ctr_id;
+      te->teid = rbuf.sess_entry.dl_s1_info.enb_teid;
+      te->enb_addr = rbuf.sess_entry.ul_s1_info.enb_addr.u.ipv4_addr;
+      journalSession(w, key, te);
+      VLOG(1) << "Assigning sess with IP addr: "
+              << rbuf.sess_entry.ue_addr.u.ipv4_addr
+              << " and teid: " << te->teid << " counter: " << curr_ctr
+              << std::endl;
+
+      setSessionRules(&pdrD, &pdrU, &farD, &farU,
+                      rbuf.sess_entry.ue_addr.u.ipv4_addr, te->teid, curr_ctr,
+                      te->enb_addr);
+      // Add PDR (DOWNLINK)
+      invokeGRPCall(b, &pdrD, args.pdrlookup, GRPC_PDR_ADD);
+      // Add PDR (UPLINK)
+      invokeGRPCall(b, &pdrU, args.pdrlookup, GRPC_PDR_ADD);
+      // Add FAR (DOWNLINK)
+      invokeGRPCall(b, &farD, args.farlookup, GRPC_FAR_ADD);
+      // Add FAR (UPLINK)
+      invokeGRPCall(b, &farU, args.farlookup, GRPC_FAR_ADD);
+
+      // Add PreQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("pre" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_ADD);
+
+      // Add PostQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("postUL" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_ADD);
+
+      // Add PostQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("postDL" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_ADD);
+      break;
+    case MSG_SESS_DEL:
+      VLOG(1) << "Got a session delete request" << std::endl;
+      {
+        TeidEntry old;
+        if (!w->zmq_sess_map.erase(key, &old)) {
+          std::cerr << "No record found!" << std::endl;
+          break;
+        }
+        enb_teid = old.teid;
+        curr_ctr = old.ctr_id;
+      }
+      journalSession(w, key, NULL);
+      VLOG(1) << "Assigning sess with IP addr: "
+              << (rbuf.sess_entry.ue_addr.u.ipv4_addr)
+              << " and teid: " << enb_teid << " counter: " << curr_ctr
+              << std::endl;
+
+      pdrD.saddr = (rbuf.sess_entry.ue_addr.u.ipv4_addr); /* ueaddr ip */
+      // Delete PDR (DOWNLINK)
+      invokeGRPCall(b, &pdrD, args.pdrlookup, GRPC_PDR_DEL);
+
+      pdrU.daddr = (rbuf.sess_entry.ue_addr.u.ipv4_addr); /* ueaddr ip */
+      // Delete PDR (UPLINK)
+      invokeGRPCall(b, &pdrU, args.pdrlookup, GRPC_PDR_DEL);
+
+      // Del FAR (DOWNLINK)
+      fa.far_id = 1;
+      fa.fseid = enb_teid;
+      invokeGRPCall(b, &fa, args.farlookup, GRPC_FAR_DEL);
+
+      // Del FAR (UPLINK)
+      fa.far_id = 0;
+      fa.fseid = enb_teid;
+      invokeGRPCall(b, &fa, args.farlookup, GRPC_FAR_DEL);
+
+      // Delete PreQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("pre" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_DEL);
+
+      // Delete PostQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("postUL" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_DEL);
+
+      // Delete PostQoS Counter
+      invokeGRPCall(b, (&curr_ctr),
+                    (("postDL" + std::string(args.qoscounter)).c_str()),
+                    GRPC_CTR_DEL);
+
+      /**
+       * The counter id goes back to the allocator once the deletes are done,
+       * so that another worker's CTR_ADD for it can't be overtaken by them
+       */
+      op->free_ctr = true;
+      op->ctr_id = curr_ctr;
+      break;
+    default:
+      break;
+  }
+
+  return b->inflight() - inflight;
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Sends back the response of a request whose calls are all done, unless
+ * it failed.
+ */
+void completeOp(PendingOp *op) {
+  if (!op->failed)
+    sendResponse(&op->resp);
+  if (op->free_ctr) {
+    VLOG(1) << "Curr Ctr returned: " << op->ctr_id << std::endl;
+    std::lock_guard<std::mutex> lock(counter_lock);
+    counter.free(op->ctr_id);
+  }
+  delete op;
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Reaps one completed gRPC call, waiting for it up to `wait_us' usecs.
+ * Sends back the response of the request once its last call is done.
+ */
+bool reapGRPCall(SessionWorker *w, uint32_t wait_us) {
+  PendingOp *op;
+
+  if (!w->client->complete((void **)&op,
+                           std::chrono::system_clock::now() +
+                               std::chrono::microseconds(wait_us)))
+    return false;
+
+  if (op != NULL && --op->rpcs == 0) {
+    w->busy.erase(op->sess_key);
+    completeOp(op);
+  }
+
+  return true;
+}
+/*--------------------------------------------------------------------------------*/
+void workerLoop(SessionWorker *w) {
+  struct msgbuf rbuf;
+
+  while (true) {
+    /* read before pop(), which then sees whatever was pushed before it */
+    bool stop = draining;
+    if (!w->ring.pop(rbuf)) {
+      if (stop && w->client->inflight() == 0)
+        return;
+      /* nothing new to issue, collect responses meanwhile */
+      if (!reapGRPCall(w, WORKER_IDLE_WAIT) && w->client->inflight() == 0)
+        std::this_thread::sleep_for(
+            std::chrono::microseconds(WORKER_IDLE_WAIT));
+      continue;
+    }
+
+    uint64_t key = SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr, DEFAULT_BEARER);
+    /* keep the requests of a session in order */
+    while (w->busy.count(key))
+      reapGRPCall(w, ZMQ_POLL_TIMEOUT * 1000);
+    /* bound the number of in-flight calls */
+    while (w->client->inflight() >= args.max_inflight)
+      reapGRPCall(w, ZMQ_POLL_TIMEOUT * 1000);
+
+    PendingOp *op = new PendingOp();
+    op->sess_key = key;
+    w->client->setOp(op);
+    op->rpcs = processMsg(w, rbuf, op);
+    w->client->setOp(NULL);
+
+    if (op->rpcs == 0) {
+      completeOp(op);
+    } else {
+      w->busy.insert(key);
+    }
+  }
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Warm restart: rebuilds the sessions journaled by the previous run, spreads
+ * them over the workers and re-programs bessd with them using bulk commands.
+ * Every worker then starts a fresh journal holding its own sessions.
+ */
+void restoreSessions() {
+  FlatMap<JournalRecord> sessions(args.counter_count);
+  std::vector<uint32_t> used;
+  std::vector<PDRArgs> pdrs;
+  std::vector<FARArgs> fars;
+  uint32_t files = 0;
+  BessClient *b = newBessClient();
+
+  /* the previous run may have had a different number of workers */
+  while (SessJournal::replay(journalPath(files), [&](const JournalRecord &r) {
+    uint64_t key = SESS_ID(r.ue_addr, DEFAULT_BEARER);
+    if (r.op == JOURNAL_SET)
+      *sessions.insert(key).first = r;
+    else
+      sessions.erase(key, NULL);
+  }))
+    files++;
+
+  /* start over from clean tables, before adding anything */
+  clearTables(b);
+
+  auto sendRules = [&]() {
+    if (!pdrs.empty())
+      b->runAddPDRsCommand(pdrs, args.pdrlookup);
+    if (!fars.empty())
+      b->runAddFARsCommand(fars, args.farlookup);
+    pdrs.clear();
+    fars.clear();
+  };
+
+  sessions.forEach([&](uint64_t key, const JournalRecord &r) {
+    SessionWorker *w = workers[std::hash<uint64_t>{}(key) % workers.size()];
+    TeidEntry *te = w->zmq_sess_map.insert(key).first;
+    uint32_t ctr_id = r.ctr_id;
+
+    te->teid = r.teid;
+    te->ctr_id = r.ctr_id;
+    te->enb_addr = r.enb_addr;
+    used.push_back(r.ctr_id);
+
+    /* created but never modified: nothing in bessd yet */
+    if (r.teid == 0)
+      return;
+
+    PDRArgs pd = pdrD, pu = pdrU;
+    FARArgs fd = farD, fu = farU;
+    setSessionRules(&pd, &pu, &fd, &fu, r.ue_addr, r.teid, r.ctr_id,
+                    r.enb_addr);
+    pdrs.push_back(pd);
+    pdrs.push_back(pu);
+    fars.push_back(fd);
+    fars.push_back(fu);
+    if (pdrs.size() >= RESYNC_BATCH)
+      sendRules();
+
+    /* counters have no bulk command, just keep them pipelined */
+    invokeGRPCall(b, &ctr_id, (("pre" + std::string(args.qoscounter)).c_str()),
+                  GRPC_CTR_ADD);
+    invokeGRPCall(b, &ctr_id,
+                  (("postUL" + std::string(args.qoscounter)).c_str()),
+                  GRPC_CTR_ADD);
+    invokeGRPCall(b, &ctr_id,
+                  (("postDL" + std::string(args.qoscounter)).c_str()),
+                  GRPC_CTR_ADD);
+    if (b->inflight() >= args.max_inflight)
+      flushGRPCalls(b);
+  });
+  sendRules();
+  flushGRPCalls(b);
+  delete b;
+
+  counter.restore(used);
+
+  /* each session lives in the journal of the worker that now owns it */
+  for (uint32_t i = 0; i < workers.size(); i++)
+    checkpointJournal(workers[i]);
+  for (uint32_t i = workers.size(); i < files; i++)
+    unlink(journalPath(i).c_str());
+
+  std::cerr << "Restored " << sessions.size() << " sessions from "
+            << args.journal << std::endl;
+}
+/*--------------------------------------------------------------------------------*/
+/**
+ * Sends keepalives to CP when it has been idle for ZMQ_POLL_TIMEOUT, and
+ * has the main thread restart the DP if CP has been gone for
+ * KEEPALIVE_TIMEOUT. Runs on its own thread so that slow gRPC calls don't
+ * delay it.
+ */
+void keepaliveLoop() {
+  struct resp_msgbuf keepalive;
+  keepalive.mtype = DPN_KEEPALIVE_REQ;
+  keepalive.op_id = 1;            // for now always 1...
+  keepalive.sess_id = 0;          // node specific message
+  keepalive.dp_id.id = my_dp_id;  // DP is not aware about its id...
+  strcpy(keepalive.dp_id.name, args.rmb.hostname);
+
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ZMQ_POLL_TIMEOUT));
+
+    int64_t idle = nowMs() - last_ack;
+    if (idle < ZMQ_POLL_TIMEOUT)
+      continue;
+
+    VLOG(1) << "ZMQ poll timeout DPID " << my_dp_id << std::endl;
+    if (idle > KEEPALIVE_TIMEOUT * 1000) {
+      std::cerr << "CP<-->DP communication broken. DPID: " << my_dp_id
+                << ". DP is restarting..." << std::endl;
+      restart_dp = true;
+      return;
+    }
+    keepalive.dp_id.id = my_dp_id;
+    sendResponse(&keepalive);
+  }
 }
 /*--------------------------------------------------------------------------------*/
 int main(int argc, char **argv) {
   GOOGLE_PROTOBUF_VERIFY_VERSION;
 
-  /* key: SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr, DEFAULT_BEARER), val:
-   * enb_teid) */
-  std::map<uint64_t, TeidEntry> zmq_sess_map;
-  std::stack<uint32_t> counter;
-  // set my_dp_id to 0, SPGW-C will give me the id
-  uint32_t my_dp_id = 0;
-  struct timeval last_ack, current_time;
-  // set it to 100 secs for the time being
-  const uint32_t dp_cp_timeout_interval = KEEPALIVE_TIMEOUT;
-  // 1 second zmq_poll timeout
-  const uint32_t zmq_poll_timeout = ZMQ_POLL_TIMEOUT;
-  Args args;
-
   context0 = zmq_ctx_new();
   context1 = zmq_ctx_new();
   context2 = zmq_ctx_new();
   // set args coming from command-line
   args.parse(argc, argv);
 
-  /* initialize stack */
-  for (int32_t k = args.counter_count - 1; k >= 0; k--)
-    counter.push(k);
-
+  /* counter ids are handed out lazily, nothing to fill in */
+  counter.init(args.counter_count);
   if (context0 == NULL || context1 == NULL || context2 == NULL) {
     std::cerr << "Failed to create context(s)!: " << strerror(errno)
               << std::endl;
@@ -213,272 +708,85 @@ int main(int argc, char **argv) {
     return EXIT_FAILURE;
   }
 
-  gettimeofday(&last_ack, NULL);
-
-  struct resp_msgbuf keepalive;
-  keepalive.mtype = DPN_KEEPALIVE_REQ;
-  keepalive.op_id = 1;            // for now always 1...
-  keepalive.sess_id = 0;          // node specific message
-  keepalive.dp_id.id = my_dp_id;  // DP is not aware about its id...
-  strcpy(keepalive.dp_id.name, args.rmb.hostname);
-
-  //  Process messages from either socket
-  while (true) {
-    zmq_pollitem_t items[] = {
-        {receiver, 0, ZMQ_POLLIN, 0},
-    };
-
-    if (zmq_poll((zmq_pollitem_t *)items, 1, zmq_poll_timeout) < 0) {
-      std::cerr << "ZMQ poll failed!: " << strerror(errno);
-      if (errno != EINTR) {
-        std::cerr << std::endl;
-        return EXIT_FAILURE;
-      } else {
-        std::cerr << "Retrying..." << std::endl;
+  last_ack = nowMs();
+
+  for (uint32_t i = 0; i < args.num_workers; i++) {
+    SessionWorker *w = new SessionWorker();
+    w->client = newBessClient();
+    /* sessions are spread evenly, size the maps so they never rehash */
+    w->zmq_sess_map.reserve(args.counter_count / args.num_workers + 1);
+    w->journal = NULL;
+    /**
+     * Room for all the sessions plus a worker's share of updates, so a
+     * checkpoint always fits and leaves slack. The file stays sparse until
+     * written.
+     */
+    if (args.journal[0] != '\0')
+      w->journal = new SessJournal(
+          journalPath(i),
+          args.counter_count + args.counter_count / args.num_workers + 1);
+    workers.push_back(w);
+  }
+  if (args.journal[0] != '\0')
+    restoreSessions();
+  for (SessionWorker *w : workers)
+    w->thread = std::thread(workerLoop, w);
+  std::thread(keepaliveLoop).detach();
+
+  /* wake up every ZMQ_POLL_TIMEOUT to check for a restart */
+  int rcv_timeout = ZMQ_POLL_TIMEOUT;
+  zmq_setsockopt(receiver, ZMQ_RCVTIMEO, &rcv_timeout, sizeof(rcv_timeout));
+
+  // this thread only receives and dispatches messages from CP
+  while (!restart_dp) {
+    struct msgbuf rbuf;
+    int size = zmq_recv(receiver, &rbuf, sizeof(rbuf), 0);
+    if (size == -1) {
+      if (errno == EINTR || errno == EAGAIN)
         continue;
-      }
+      std::cerr << "Error in zmq reception: " << strerror(errno) << std::endl;
+      break;
     }
-    if (items[0].revents & ZMQ_POLLIN) {
-      // as long as we get packets from control path we are good
-      gettimeofday(&last_ack, NULL);
-      bool send_resp = true;
-      struct msgbuf rbuf;
-      struct resp_msgbuf resp;
-      int size = zmq_recv(receiver, &rbuf, sizeof(rbuf), 0);
-      if (size == -1) {
-        std::cerr << "Error in zmq reception: " << strerror(errno) << std::endl;
+    // as long as we get packets from control path we are good
+    last_ack = nowMs();
+
+    long mtype = rbuf.mtype;
+    switch (mtype) {
+      case MSG_SESS_CRE:
+      case MSG_SESS_MOD:
+      case MSG_SESS_DEL: {
+        uint64_t key =
+            SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr, DEFAULT_BEARER);
+        SessionWorker *w = workers[std::hash<uint64_t>{}(key) % workers.size()];
+        while (!w->ring.push(rbuf))
+          std::this_thread::yield();
+      } break;
+      case MSG_KEEPALIVE_ACK:
+        my_dp_id = rbuf.dp_id.id;
+        VLOG(1) << "Got a keepalive ack from CP, and it gave me dp_id: "
+                << my_dp_id << std::endl;
         break;
-      }
-      long mtype = rbuf.mtype;
-      uint32_t enb_teid = 0;
-      uint32_t curr_ctr = 0;
-      TeidEntry te;
-      memset(&resp, 0, sizeof(struct resp_msgbuf));
-      switch (mtype) {
-        case MSG_SESS_CRE:
-          VLOG(1) << "Got a session create request, ";
-          VLOG(1) << "UEADDR: " << rbuf.sess_entry.ue_addr
-                  << ", ENODEADDR: " << rbuf.sess_entry.ul_s1_info.enb_addr
-                  << ", sgw_teid: " << (rbuf.sess_entry.ul_s1_info.sgw_teid)
-                  << ", enb_teid: "
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << " ("
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << ")"
-                  << std::endl;
-          resp.op_id = rbuf.sess_entry.op_id;
-          // SPGW-C returns the DP ID
-          my_dp_id = rbuf.dp_id.id;
-          resp.dp_id.id = rbuf.dp_id.id;
-          resp.mtype = DPN_RESPONSE;
-          te.teid = 0;
-          te.ctr_id = counter.top();
-          zmq_sess_map[SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr,
-                               DEFAULT_BEARER)] = te;
-          VLOG(1) << "Assigning sess with IP addr: "
-                  << rbuf.sess_entry.ue_addr.u.ipv4_addr
-                  << " counter: " << te.ctr_id << std::endl;
-          resp.sess_id = rbuf.sess_entry.sess_id;
-          /* ctr_id is used up */
-          counter.pop();
-          break;
-        case MSG_SESS_MOD:
-          VLOG(1) << "Got a session modify request, ";
-          VLOG(1) << "UEADDR: " << rbuf.sess_entry.ue_addr
-                  << ", ENODEADDR: " << rbuf.sess_entry.ul_s1_info.enb_addr
-                  << ", sgw_teid: " << (rbuf.sess_entry.ul_s1_info.sgw_teid)
-                  << ", enb_teid: "
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << " ("
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << ")"
-                  << std::endl;
-          resp.op_id = rbuf.sess_entry.op_id;
-          resp.dp_id.id = rbuf.dp_id.id;
-          resp.mtype = DPN_RESPONSE;
-          resp.sess_id = rbuf.sess_entry.sess_id;
-          if (zmq_sess_map.find(SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr,
-                                        DEFAULT_BEARER)) ==
-              zmq_sess_map.end()) {
-            std::cerr << "No record found!" << std::endl;
-            break;
-          } else {
-            curr_ctr = zmq_sess_map[SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr,
-                                            DEFAULT_BEARER)]
-                           .ctr_id;
-            te.teid = rbuf.sess_entry.dl_s1_info.enb_teid;
-            te.ctr_id = curr_ctr;
-            zmq_sess_map[SESS_ID(rbuf.sess_entry.ue_addr.u.ipv4_addr,
-                                 DEFAULT_BEARER)] = te;
-            VLOG(1) << "Assigning sess with IP addr: "
-                    << rbuf.sess_entry.ue_addr.u.ipv4_addr
-                    << " and teid: " << te.teid << " counter: " << te.ctr_id
-                    << std::endl;
-          }
-          pdrD.saddr = rbuf.sess_entry.ue_addr.u.ipv4_addr; /* ueaddr ip */
-          pdrD.fseid = rbuf.sess_entry.dl_s1_info.enb_teid; /* fseid */
-          pdrD.ctr_id = curr_ctr;                           /* ctr_id */
-          // Add PDR (DOWNLINK)
-          invokeGRPCall(args, &pdrD, args.pdrlookup, GRPC_PDR_ADD);
-
-          pdrU.daddr = rbuf.sess_entry.ue_addr.u.ipv4_addr; /* ueaddr ip */
-          pdrU.fseid = rbuf.sess_entry.dl_s1_info.enb_teid; /* fseid */
-          pdrU.ctr_id = curr_ctr;                           /* ctr_id */
-          // Add PDR (UPLINK)
-          invokeGRPCall(args, &pdrU, args.pdrlookup, GRPC_PDR_ADD);
-
-          farD.fseid = rbuf.sess_entry.dl_s1_info.enb_teid; /* fseid */
-          farD.tun_src_ip =
-              ntohl((uint32_t)(inet_addr(args.s1u_sgw_ip))); /* n3 addr */
-          farD.tun_dst_ip =
-              rbuf.sess_entry.ul_s1_info.enb_addr.u.ipv4_addr; /* enb addr */
-          farD.teid = rbuf.sess_entry.dl_s1_info.enb_teid;     /* enb_teid */
-          // Add FAR (DOWNLINK)
-          invokeGRPCall(args, &farD, args.farlookup, GRPC_FAR_ADD);
-
-          farU.fseid = rbuf.sess_entry.dl_s1_info.enb_teid; /* fseid */
-          // Add FAR (UPLINK)
-          invokeGRPCall(args, &farU, args.farlookup, GRPC_FAR_ADD);
-
-          // Add PreQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("pre" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_ADD);
-
-          // Add PostQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("postUL" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_ADD);
-
-          // Add PostQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("postDL" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_ADD);
-          break;
-        case MSG_SESS_DEL:
-          VLOG(1) << "Got a session delete request" << std::endl;
-          VLOG(1) << "UEADDR: " << rbuf.sess_entry.ue_addr
-                  << ", ENODEADDR: " << rbuf.sess_entry.ul_s1_info.enb_addr
-                  << ", sgw_teid: " << (rbuf.sess_entry.ul_s1_info.sgw_teid)
-                  << ", enb_teid: "
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << " ("
-                  << ntohl(rbuf.sess_entry.dl_s1_info.enb_teid) << ")"
-                  << std::endl;
-          resp.op_id = rbuf.sess_entry.op_id;
-          resp.dp_id.id = rbuf.dp_id.id;
-          resp.mtype = DPN_RESPONSE;
-          resp.sess_id = rbuf.sess_entry.sess_id;
-          /* why is the ue ip address stored in reverse endian order just in
-           * delete message? */
-          if (zmq_sess_map.find(SESS_ID((rbuf.sess_entry.ue_addr.u.ipv4_addr),
-                                        DEFAULT_BEARER)) ==
-              zmq_sess_map.end()) {
-            std::cerr << "No record found!" << std::endl;
-            break;
-          } else {
-            enb_teid =
-                zmq_sess_map[SESS_ID((rbuf.sess_entry.ue_addr.u.ipv4_addr),
-                                     DEFAULT_BEARER)]
-                    .teid;
-            curr_ctr =
-                zmq_sess_map[SESS_ID((rbuf.sess_entry.ue_addr.u.ipv4_addr),
-                                     DEFAULT_BEARER)]
-                    .ctr_id;
-            VLOG(1) << "Assigning sess with IP addr: "
-                    << (rbuf.sess_entry.ue_addr.u.ipv4_addr)
-                    << " and teid: " << enb_teid << " counter: " << curr_ctr
-                    << std::endl;
-          }
-          {
-            std::map<std::uint64_t, TeidEntry>::iterator it = zmq_sess_map.find(
-                SESS_ID((rbuf.sess_entry.ue_addr.u.ipv4_addr), DEFAULT_BEARER));
-            zmq_sess_map.erase(it);
-          }
-
-          pdrD.saddr = (rbuf.sess_entry.ue_addr.u.ipv4_addr); /* ueaddr ip */
-          // Delete PDR (DOWNLINK)
-          invokeGRPCall(args, &pdrD, args.pdrlookup, GRPC_PDR_DEL);
-
-          pdrU.daddr = (rbuf.sess_entry.ue_addr.u.ipv4_addr); /* ueaddr ip */
-          // Delete PDR (UPLINK)
-          invokeGRPCall(args, &pdrU, args.pdrlookup, GRPC_PDR_DEL);
-
-          // Del FAR (DOWNLINK)
-          FARArgs fa;
-          fa.far_id = 1;
-          fa.fseid = enb_teid;
-          invokeGRPCall(args, &fa, args.farlookup, GRPC_FAR_DEL);
-
-          // Del FAR (UPLINK)
-          fa.far_id = 0;
-          fa.fseid = enb_teid;
-          invokeGRPCall(args, &fa, args.farlookup, GRPC_FAR_DEL);
-
-          // Delete PreQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("pre" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_DEL);
-
-          // Delete PostQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("postUL" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_DEL);
-
-          // Delete PostQoS Counter
-          invokeGRPCall(args, (&curr_ctr),
-                        (("postDL" + std::string(args.qoscounter)).c_str()),
-                        GRPC_CTR_DEL);
-
-          /* freed up counter id is returned to the stack */
-          VLOG(1) << "Curr Ctr returned: " << curr_ctr << std::endl;
-          counter.push(curr_ctr);
-          break;
-        case MSG_KEEPALIVE_ACK:
-          my_dp_id = rbuf.dp_id.id;
-          send_resp = false;
-          VLOG(1) << "Got a keepalive ack from CP, and it gave me dp_id: "
-                  << my_dp_id << std::endl;
-          break;
-        default:
-          send_resp = false;
-          VLOG(1) << "Got a request with mtype: " << mtype << std::endl;
-          break;
-      }
-
-      if (send_resp == true) {
-        size = zmq_send(sender, &resp, sizeof(resp), ZMQ_NOBLOCK);
-        if (size == -1) {
-          std::cerr << "Error in zmq sending: " << strerror(errno) << std::endl;
-          break;
-        } else {
-          VLOG(1) << "Sending back response block" << std::endl;
-        }
-      }
-    } else {
-      VLOG(1) << "ZMQ poll timeout DPID " << my_dp_id << std::endl;
-      gettimeofday(&current_time, NULL);
-      if (current_time.tv_sec - last_ack.tv_sec > dp_cp_timeout_interval) {
-        invokeGRPCall(args, NULL, args.pdrlookup, GRPC_PDR_CLR);
-        invokeGRPCall(args, NULL, args.farlookup, GRPC_FAR_CLR);
-        invokeGRPCall(args, NULL,
-                      (("pre" + std::string(args.qoscounter)).c_str()),
-                      GRPC_CTR_CLR);
-        invokeGRPCall(args, NULL,
-                      (("postUL" + std::string(args.qoscounter)).c_str()),
-                      GRPC_CTR_CLR);
-        invokeGRPCall(args, NULL,
-                      (("postDL" + std::string(args.qoscounter)).c_str()),
-                      GRPC_CTR_CLR);
-
-        std::cerr << "CP<-->DP communication broken. DPID: " << my_dp_id
-                  << ". DP is restarting..." << std::endl;
-        force_restart(argc, argv);
-      }
-      keepalive.dp_id.id = my_dp_id;
-      int size = zmq_send(sender, &keepalive, sizeof(keepalive), ZMQ_NOBLOCK);
-      if (size == -1) {
-        std::cerr << "Error in zmq sending: " << strerror(errno) << std::endl;
+      default:
+        VLOG(1) << "Got a request with mtype: " << mtype << std::endl;
         break;
-      }
     }
   }
 
+  /* let the workers finish what they got, nothing programs bessd after it */
+  draining = true;
+  for (SessionWorker *w : workers)
+    w->thread.join();
+
+  if (restart_dp) {
+    /* with a journal, the restarted DP re-syncs bessd from it instead */
+    if (args.journal[0] == '\0') {
+      std::unique_ptr<BessClient> b(newBessClient());
+      clearTables(b.get());
+      flushGRPCalls(b.get());
+    }
+    force_restart(argc, argv);
+  }
+
   return EXIT_SUCCESS;
 }
 /*--------------------------------------------------------------------------------*/
@@ -7,15 +7,19 @@ import (
 	"context"
 	"encoding/binary"
 	"flag"
+	"fmt"
 	"log"
 	"math"
 	"net"
+	"strconv"
+	"strings"
 	"time"
 
 	pb "github.com/omec-project/upf-epc/pfcpiface/bess_pb"
 	"github.com/prometheus/client_golang/prometheus"
 	"github.com/wmnsk/go-pfcp/ie"
 	"google.golang.org/grpc"
+	"google.golang.org/protobuf/encoding/protowire"
 	"google.golang.org/protobuf/types/known/anypb"
 )
 
@@ -38,7 +42,18 @@ type bess struct {
 	conn             *grpc.ClientConn
 	endMarkerSocket  net.Conn
 	notifyBessSocket net.Conn
+	gtpuSignalSocket net.Conn
 	endMarkerChan    chan []byte
+	// QERs and FARs live in pdrLookup (fused session table)
+	fused bool
+	// sessionFilter takes the PDRs too
+	sessionFilter bool
+	// dlBuffer queues the packets of buffering FARs
+	dlBuffer bool
+	// notifications are lists of FSEIDs (ddnNotify) rather than packets
+	ddnBatched bool
+	// endMarker builds the end markers
+	endMarkerModule bool
 }
 
 func (b *bess) setInfo(udpConn *net.UDPConn, udpAddr net.Addr, pconn *PFCPConn) {
@@ -53,6 +68,10 @@ func (b *bess) isConnected(accessIP *net.IP) bool {
 }
 
 func (b *bess) sendEndMarkers(endMarkerList *[][]byte) error {
+	if b.endMarkerModule {
+		return b.sendEndMarkerTunnels(*endMarkerList)
+	}
+
 	for _, eMarker := range *endMarkerList {
 		b.endMarkerChan <- eMarker
 	}
@@ -63,7 +82,12 @@ func (b *bess) sendEndMarkers(endMarkerList *[][]byte) error {
 func (b *bess) sendMsgToUPF(method string, pdrs []pdr, fars []far, qers []qer) uint8 {
 	// create context
 	var cause uint8 = ie.CauseRequestAccepted
-	calls := len(pdrs) + len(fars) + len(qers)
+	calls := 0
+	for _, n := range []int{len(pdrs), len(fars), len(qers)} {
+		if n != 0 {
+			calls++
+		}
+	}
 	if calls == 0 {
 		return cause
 	}
@@ -72,48 +96,86 @@ func (b *bess) sendMsgToUPF(method string, pdrs []pdr, fars []far, qers []qer) u
 	defer cancel()
 	done := make(chan bool)
 
-	for _, pdr := range pdrs {
-		// TODO: https://github.com/omec-project/upf-epc/issues/251
-		// pdr.printPDR()
+	// All the rules of a table go in a single bulk command
+	// TODO: https://github.com/omec-project/upf-epc/issues/251
+	// pdr.printPDR(), far.printFAR()
+	if len(pdrs) != 0 {
 		switch method {
 		case "add":
 			fallthrough
 		case "mod":
-			b.addPDR(ctx, done, pdr)
+			b.addPDRs(ctx, done, pdrs)
 		case "del":
-			b.delPDR(ctx, done, pdr)
+			b.delPDRs(ctx, done, pdrs)
 		}
 	}
-	for _, far := range fars {
-		// TODO: https://github.com/omec-project/upf-epc/issues/251
-		// far.printFAR()
+	if len(fars) != 0 {
 		switch method {
 		case "add":
 			fallthrough
 		case "mod":
-			b.addFAR(ctx, done, far)
+			b.addFARs(ctx, done, fars)
 		case "del":
-			b.delFAR(ctx, done, far)
+			b.delFARs(ctx, done, fars)
 		}
 	}
-	for _, qer := range qers {
-		// qer.printQER()
+	if len(qers) != 0 {
 		switch method {
 		case "add":
 			fallthrough
 		case "mod":
-			b.addQER(ctx, done, qer)
+			b.addQERs(ctx, done, qers)
 		case "del":
-			b.delQER(ctx, done, qer)
+			b.delQERs(ctx, done, qers)
 		}
 	}
 	rc := b.GRPCJoin(calls, Timeout, done)
 	if !rc {
 		log.Println("Unable to make GRPC calls")
 	}
+
+	// Now that the FARs are in, release (or drop) what they held back
+	if b.dlBuffer && len(fars) != 0 && method != "add" {
+		b.flushDLBuffer(ctx, fars, method == "del")
+	}
 	return cause
 }
 
+// flushDLBuffer releases the packets dlBuffer queued for the sessions of the
+// fars that forward now, or drops them if the fars are being deleted.
+func (b *bess) flushDLBuffer(ctx context.Context, fars []far, drop bool) {
+	// DlBufferCommandFlushArg is newer than the Go bindings: encode it by hand
+	var arg []byte
+	seen := make(map[uint64]bool)
+	for _, f := range fars {
+		if seen[f.fseID] || (!drop && f.applyAction&ActionForward == 0) {
+			continue
+		}
+		seen[f.fseID] = true
+		arg = protowire.AppendTag(arg, 1, protowire.VarintType)
+		arg = protowire.AppendVarint(arg, f.fseID)
+	}
+	if len(arg) == 0 {
+		return
+	}
+	if drop {
+		arg = protowire.AppendTag(arg, 2, protowire.VarintType)
+		arg = protowire.AppendVarint(arg, 1)
+	}
+
+	_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
+		Name: "dlBuffer",
+		Cmd:  "flush",
+		Arg: &anypb.Any{
+			TypeUrl: "type.googleapis.com/bess.pb.DlBufferCommandFlushArg",
+			Value:   arg,
+		},
+	})
+	if err != nil {
+		log.Println("dlBuffer flush failed!:", err)
+	}
+}
+
 func (b *bess) sendDeleteAllSessionsMsgtoUPF() {
 	ctx, cancel := context.WithTimeout(context.Background(), Timeout)
 	defer cancel()
@@ -274,6 +336,311 @@ func (b *bess) summaryLatencyJitter(uc *upfCollector, ch chan<- prometheus.Metri
 
 }
 
+// Classes of the modules that keep ModuleStats (get_stats/set_stats)
+var statsMclasses = map[string]bool{
+	"GtpuParser": true,
+	"GtpuEncap":  true,
+	"GtpuDecap":  true,
+	"Counter":    true,
+	"IPDefrag":   true,
+	"IPFrag":     true,
+}
+
+// moduleStatsResponse mirrors bess.pb.ModuleStatsResponse
+type moduleStatsResponse struct {
+	enabled      bool
+	batches      uint64
+	packets      uint64
+	cycles       uint64
+	batchCycles  []uint64
+	packetCycles []uint64
+	batchSize    []uint64
+	gatePackets  []uint64
+}
+
+// decodeModuleStats decodes a ModuleStatsResponse, which is newer than the
+// Go bindings
+func decodeModuleStats(b []byte) (*moduleStatsResponse, error) {
+	var res moduleStatsResponse
+
+	for len(b) > 0 {
+		num, typ, n := protowire.ConsumeTag(b)
+		if n < 0 {
+			return nil, protowire.ParseError(n)
+		}
+		b = b[n:]
+
+		var values []uint64
+		switch typ {
+		case protowire.VarintType:
+			v, n := protowire.ConsumeVarint(b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			values = append(values, v)
+		case protowire.BytesType:
+			// packed repeated field
+			packed, n := protowire.ConsumeBytes(b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			for len(packed) > 0 {
+				v, n := protowire.ConsumeVarint(packed)
+				if n < 0 {
+					return nil, protowire.ParseError(n)
+				}
+				packed = packed[n:]
+				values = append(values, v)
+			}
+		default:
+			n := protowire.ConsumeFieldValue(num, typ, b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			continue
+		}
+
+		switch num {
+		case 1:
+			res.enabled = values[0] != 0
+		case 2:
+			res.batches = values[0]
+		case 3:
+			res.packets = values[0]
+		case 4:
+			res.cycles = values[0]
+		case 5:
+			res.batchCycles = append(res.batchCycles, values...)
+		case 6:
+			res.packetCycles = append(res.packetCycles, values...)
+		case 7:
+			res.batchSize = append(res.batchSize, values...)
+		case 8:
+			res.gatePackets = append(res.gatePackets, values...)
+		}
+	}
+
+	return &res, nil
+}
+
+func (b *bess) getModuleStats(name string) *moduleStatsResponse {
+	any, err := anypb.New(&pb.EmptyArg{})
+	if err != nil {
+		log.Println("Error marshalling the arg", err)
+		return nil
+	}
+
+	ctx := context.Background()
+	modRes, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
+		Name: name,
+		Cmd:  "get_stats",
+		Arg:  any,
+	})
+	if err != nil || modRes.GetError() != nil {
+		log.Println("Error calling get_stats on module", name, err, modRes.GetError().GetErrmsg())
+		return nil
+	}
+
+	res, err := decodeModuleStats(modRes.GetData().GetValue())
+	if err != nil {
+		log.Println("Error unmarshalling the response", name, err)
+		return nil
+	}
+
+	return res
+}
+
+func (b *bess) moduleStats(uc *upfCollector, ch chan<- prometheus.Metric) {
+	// [i] counts what took 2^i to 2^(i+1) cycles
+	log2Buckets := func(counts []uint64) map[float64]uint64 {
+		buckets := make(map[float64]uint64)
+		var sum uint64
+		for i, c := range counts {
+			sum += c
+			buckets[float64(uint64(2)<<i)] = sum
+		}
+		return buckets
+	}
+	// [i] counts the batches of i packets
+	sizeBuckets := func(counts []uint64) map[float64]uint64 {
+		buckets := make(map[float64]uint64)
+		var sum uint64
+		for i, c := range counts {
+			sum += c
+			buckets[float64(i)] = sum
+		}
+		return buckets
+	}
+
+	ctx := context.Background()
+	mods, err := b.client.ListModules(ctx, &pb.EmptyRequest{})
+	if err != nil {
+		log.Println("Error calling ListModules", err)
+		return
+	}
+
+	for _, m := range mods.GetModules() {
+		if !statsMclasses[m.Mclass] {
+			continue
+		}
+
+		res := b.getModuleStats(m.Name)
+		if res == nil || !res.enabled {
+			continue
+		}
+
+		ch <- prometheus.MustNewConstHistogram(uc.moduleBatchCycles,
+			res.batches, float64(res.cycles), log2Buckets(res.batchCycles), m.Name)
+		ch <- prometheus.MustNewConstHistogram(uc.modulePacketCycles,
+			res.packets, float64(res.cycles), log2Buckets(res.packetCycles), m.Name)
+		ch <- prometheus.MustNewConstHistogram(uc.moduleBatchSize,
+			res.batches, float64(res.packets), sizeBuckets(res.batchSize), m.Name)
+
+		for gate, packets := range res.gatePackets {
+			if packets == 0 {
+				continue
+			}
+			ch <- prometheus.MustNewConstMetric(uc.moduleGatePackets,
+				prometheus.CounterValue, float64(packets), m.Name, strconv.Itoa(gate))
+		}
+	}
+}
+
+// dropCounterResponse mirrors the per reason part of
+// bess.pb.DropCounterCommandGetResponse
+type dropCounterResponse struct {
+	reasons []string
+	packets []uint64
+}
+
+// decodeDropCounter decodes a DropCounterCommandGetResponse, which is newer
+// than the bess.pb bindings, leaving out the per session drops.
+func decodeDropCounter(b []byte) (*dropCounterResponse, error) {
+	var res dropCounterResponse
+
+	for len(b) > 0 {
+		num, typ, n := protowire.ConsumeTag(b)
+		if n < 0 {
+			return nil, protowire.ParseError(n)
+		}
+		b = b[n:]
+
+		switch {
+		case num == 1 && typ == protowire.BytesType:
+			v, n := protowire.ConsumeString(b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			res.reasons = append(res.reasons, v)
+		case num == 2 && typ == protowire.BytesType:
+			// packed repeated field
+			packed, n := protowire.ConsumeBytes(b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			for len(packed) > 0 {
+				v, n := protowire.ConsumeVarint(packed)
+				if n < 0 {
+					return nil, protowire.ParseError(n)
+				}
+				packed = packed[n:]
+				res.packets = append(res.packets, v)
+			}
+		case num == 2 && typ == protowire.VarintType:
+			v, n := protowire.ConsumeVarint(b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+			res.packets = append(res.packets, v)
+		default:
+			n := protowire.ConsumeFieldValue(num, typ, b)
+			if n < 0 {
+				return nil, protowire.ParseError(n)
+			}
+			b = b[n:]
+		}
+	}
+
+	if len(res.reasons) != len(res.packets) {
+		return nil, fmt.Errorf("%d reasons for %d counters", len(res.reasons), len(res.packets))
+	}
+
+	return &res, nil
+}
+
+func (b *bess) pipelineDrops(uc *upfCollector, ch chan<- prometheus.Metric) {
+	ctx := context.Background()
+	modRes, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
+		Name: "dropCounter",
+		Cmd:  "get",
+		Arg: &anypb.Any{
+			TypeUrl: "type.googleapis.com/bess.pb.DropCounterCommandGetArg",
+		},
+	})
+	if err != nil || modRes.GetError() != nil {
+		log.Println("Error calling get on dropCounter", err, modRes.GetError().GetErrmsg())
+		return
+	}
+
+	res, err := decodeDropCounter(modRes.GetData().GetValue())
+	if err != nil {
+		log.Println("Error unmarshalling the response", err)
+		return
+	}
+
+	for i, reason := range res.reasons {
+		ch <- prometheus.MustNewConstMetric(uc.pipelineDropped,
+			prometheus.CounterValue, float64(res.packets[i]), reason)
+	}
+}
+
+// Offsets in the end markers addEndMarker builds (Ethernet, IPv4, UDP, GTP-U)
+const (
+	endMarkerIPSrc = 14 + 12
+	endMarkerTEID  = 14 + 20 + 8 + 4
+)
+
+// sendEndMarkerTunnels has the endMarker module build endMarkers, out of
+// their tunnels (src IP, dst IP, TEID).
+func (b *bess) sendEndMarkerTunnels(endMarkers [][]byte) error {
+	var tunnels []byte
+	for _, m := range endMarkers {
+		if len(m) < endMarkerTEID+4 {
+			continue
+		}
+		tunnels = append(tunnels, m[endMarkerIPSrc:endMarkerIPSrc+8]...)
+		tunnels = append(tunnels, m[endMarkerTEID:endMarkerTEID+4]...)
+	}
+	if len(tunnels) == 0 {
+		return nil
+	}
+
+	// EndMarkerCommandSendArg is newer than the Go bindings: encode it by hand
+	arg := protowire.AppendTag(nil, 1, protowire.BytesType)
+	arg = protowire.AppendBytes(arg, tunnels)
+
+	ctx, cancel := context.WithTimeout(context.Background(), Timeout)
+	defer cancel()
+	_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
+		Name: "endMarker",
+		Cmd:  "send",
+		Arg: &anypb.Any{
+			TypeUrl: "type.googleapis.com/bess.pb.EndMarkerCommandSendArg",
+			Value:   arg,
+		},
+	})
+	if err != nil {
+		log.Println("endMarker send failed!:", err)
+	}
+	return err
+}
+
 func (b *bess) endMarkerSendLoop(endMarkerChan chan []byte) {
 	for outPacket := range endMarkerChan {
 		_, err := b.endMarkerSocket.Write(outPacket)
@@ -287,14 +654,40 @@ func (b *bess) notifyListen(reportNotifyChan chan<- uint64) {
 
 	for {
 		buf := make([]byte, 512)
-		_, err := b.notifyBessSocket.Read(buf)
+		n, err := b.notifyBessSocket.Read(buf)
 		if err != nil {
 			return
 		}
 
-		d := buf[0:8]
-		fseid := binary.LittleEndian.Uint64(d)
-		reportNotifyChan <- fseid
+		// A packet prefixed with its FSEID, or just FSEIDs
+		if !b.ddnBatched {
+			n = 8
+		}
+		for i := 0; i+8 <= n; i += 8 {
+			fseid := binary.LittleEndian.Uint64(buf[i : i+8])
+			reportNotifyChan <- fseid
+		}
+	}
+}
+
+// gtpuSignalListen reads the (message type, IP, TEID) events the fastpath
+// prepends to the GTP-U signalling messages it receives
+func (b *bess) gtpuSignalListen(gtpuSignalChan chan<- gtpuSignal) {
+	for {
+		buf := make([]byte, 512)
+		n, err := b.gtpuSignalSocket.Read(buf)
+		if err != nil {
+			return
+		}
+		if n < 9 {
+			continue
+		}
+
+		gtpuSignalChan <- gtpuSignal{
+			msgType: buf[0],
+			ip:      binary.BigEndian.Uint32(buf[1:5]),
+			teid:    binary.BigEndian.Uint32(buf[5:9]),
+		}
 	}
 }
 
@@ -321,6 +714,11 @@ func (b *bess) setUpfInfo(u *upf, conf *Conf) {
 	}
 
 	b.client = pb.NewBESSControlClient(b.conn)
+	b.fused = conf.TwoStagePdr && conf.FusedSessionTable
+	b.sessionFilter = conf.SessionFilter
+	b.dlBuffer = conf.DlBuffer
+	b.ddnBatched = conf.DdnHolddownMs != 0
+	b.endMarkerModule = conf.EndMarkerModule
 	if conf.EnableNotifyBess {
 		notifySockAddr := conf.NotifySockAddr
 		if notifySockAddr == "" {
@@ -334,7 +732,16 @@ func (b *bess) setUpfInfo(u *upf, conf *Conf) {
 		go b.notifyListen(u.reportNotifyChan)
 	}
 
-	if conf.EnableEndMarker {
+	if conf.GtpuSignalSockAddr != "" {
+		b.gtpuSignalSocket, errin = net.Dial("unixpacket", conf.GtpuSignalSockAddr)
+		if errin != nil {
+			log.Println("dial error:", errin)
+			return
+		}
+		go b.gtpuSignalListen(u.gtpuSignalChan)
+	}
+
+	if conf.EnableEndMarker && !b.endMarkerModule {
 		pfcpCommAddr := conf.EndMarkerSockAddr
 		if pfcpCommAddr == "" {
 			pfcpCommAddr = PfcpAddr
@@ -540,236 +947,267 @@ func (b *bess) sim(u *upf, method string) {
 }
 
 func (b *bess) processPDR(ctx context.Context, any *anypb.Any, method string) {
-	if method != "add" && method != "delete" && method != "clear" {
+	switch method {
+	case "add", "delete", "add_bulk", "delete_bulk", "clear":
+	default:
 		log.Println("Invalid method name: ", method)
 		return
 	}
 
-	_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
-		Name: "pdrLookup",
-		Cmd:  method,
-		Arg:  any,
-	})
-	if err != nil {
-		log.Println("pdrLookup method failed!:", err)
+	// Keys get into sessionFilter before pdrLookup has their PDRs, and
+	// leave it after, so that it never drops packets pdrLookup would match
+	modules := []string{"pdrLookup"}
+	if b.sessionFilter {
+		if strings.HasPrefix(method, "add") {
+			modules = []string{"sessionFilter", "pdrLookup"}
+		} else {
+			modules = append(modules, "sessionFilter")
+		}
+	}
+
+	for _, module := range modules {
+		_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
+			Name: module,
+			Cmd:  method,
+			Arg:  any,
+		})
+		if err != nil {
+			log.Println(module, "method failed!:", err)
+		}
 	}
 }
 
-func (b *bess) addPDR(ctx context.Context, done chan<- bool, p pdr) {
-	go func() {
-		var any *anypb.Any
-		var err error
+func pdrRule(p pdr) *pb.WildcardMatchCommandAddArg {
+	return &pb.WildcardMatchCommandAddArg{
+		Gate:     uint64(p.needDecap),
+		Priority: int64(math.MaxUint32 - p.precedence),
+		Values: []*pb.FieldData{
+			intEnc(uint64(p.srcIface)),     /* src_iface */
+			intEnc(uint64(p.tunnelIP4Dst)), /* tunnel_ipv4_dst */
+			intEnc(uint64(p.tunnelTEID)),   /* enb_teid */
+			intEnc(uint64(p.srcIP)),        /* ueaddr ip*/
+			intEnc(uint64(p.dstIP)),        /* inet ip */
+			intEnc(uint64(p.srcPort)),      /* ue port */
+			intEnc(uint64(p.dstPort)),      /* inet port */
+			intEnc(uint64(p.proto)),        /* proto id */
+		},
+		Masks: []*pb.FieldData{
+			intEnc(uint64(p.srcIfaceMask)),     /* src_iface-mask */
+			intEnc(uint64(p.tunnelIP4DstMask)), /* tunnel_ipv4_dst-mask */
+			intEnc(uint64(p.tunnelTEIDMask)),   /* enb_teid-mask */
+			intEnc(uint64(p.srcIPMask)),        /* ueaddr ip-mask */
+			intEnc(uint64(p.dstIPMask)),        /* inet ip-mask */
+			intEnc(uint64(p.srcPortMask)),      /* ue port-mask */
+			intEnc(uint64(p.dstPortMask)),      /* inet port-mask */
+			intEnc(uint64(p.protoMask)),        /* proto id-mask */
+		},
+		Valuesv: []*pb.FieldData{
+			intEnc(uint64(p.pdrID)), /* pdr-id */
+			intEnc(uint64(p.fseID)), /* fseid */
+			intEnc(uint64(p.ctrID)), /* ctr_id */
+			intEnc(uint64(p.qerID)), /* qer_id */
+			intEnc(uint64(p.farID)), /* far_id */
+		},
+	}
+}
 
-		f := &pb.WildcardMatchCommandAddArg{
-			Gate:     uint64(p.needDecap),
-			Priority: int64(math.MaxUint32 - p.precedence),
-			Values: []*pb.FieldData{
-				intEnc(uint64(p.srcIface)),     /* src_iface */
-				intEnc(uint64(p.tunnelIP4Dst)), /* tunnel_ipv4_dst */
-				intEnc(uint64(p.tunnelTEID)),   /* enb_teid */
-				intEnc(uint64(p.srcIP)),        /* ueaddr ip*/
-				intEnc(uint64(p.dstIP)),        /* inet ip */
-				intEnc(uint64(p.srcPort)),      /* ue port */
-				intEnc(uint64(p.dstPort)),      /* inet port */
-				intEnc(uint64(p.proto)),        /* proto id */
-			},
-			Masks: []*pb.FieldData{
-				intEnc(uint64(p.srcIfaceMask)),     /* src_iface-mask */
-				intEnc(uint64(p.tunnelIP4DstMask)), /* tunnel_ipv4_dst-mask */
-				intEnc(uint64(p.tunnelTEIDMask)),   /* enb_teid-mask */
-				intEnc(uint64(p.srcIPMask)),        /* ueaddr ip-mask */
-				intEnc(uint64(p.dstIPMask)),        /* inet ip-mask */
-				intEnc(uint64(p.srcPortMask)),      /* ue port-mask */
-				intEnc(uint64(p.dstPortMask)),      /* inet port-mask */
-				intEnc(uint64(p.protoMask)),        /* proto id-mask */
-			},
-			Valuesv: []*pb.FieldData{
-				intEnc(uint64(p.pdrID)), /* pdr-id */
-				intEnc(uint64(p.fseID)), /* fseid */
-				intEnc(uint64(p.ctrID)), /* ctr_id */
-				intEnc(uint64(p.qerID)), /* qer_id */
-				intEnc(uint64(p.farID)), /* far_id */
-			},
+func (b *bess) addPDRs(ctx context.Context, done chan<- bool, pdrs []pdr) {
+	go func() {
+		f := &pb.WildcardMatchConfig{}
+		for _, p := range pdrs {
+			f.Rules = append(f.Rules, pdrRule(p))
 		}
-		any, err = anypb.New(f)
+
+		any, err := anypb.New(f)
 		if err != nil {
-			log.Println("Error marshalling the rule", f, err)
+			log.Println("Error marshalling the rules", f, err)
 			return
 		}
 
-		b.processPDR(ctx, any, "add")
+		b.processPDR(ctx, any, "add_bulk")
 		done <- true
 	}()
 }
 
-func (b *bess) delPDR(ctx context.Context, done chan<- bool, p pdr) {
+func (b *bess) delPDRs(ctx context.Context, done chan<- bool, pdrs []pdr) {
 	go func() {
-		var any *anypb.Any
-		var err error
-
-		f := &pb.WildcardMatchCommandDeleteArg{
-			Values: []*pb.FieldData{
-				intEnc(uint64(p.srcIface)),     /* src_iface */
-				intEnc(uint64(p.tunnelIP4Dst)), /* tunnel_ipv4_dst */
-				intEnc(uint64(p.tunnelTEID)),   /* enb_teid */
-				intEnc(uint64(p.srcIP)),        /* ueaddr ip*/
-				intEnc(uint64(p.dstIP)),        /* inet ip */
-				intEnc(uint64(p.srcPort)),      /* ue port */
-				intEnc(uint64(p.dstPort)),      /* inet port */
-				intEnc(uint64(p.proto)),        /* proto id */
-			},
-			Masks: []*pb.FieldData{
-				intEnc(uint64(p.srcIfaceMask)),     /* src_iface-mask */
-				intEnc(uint64(p.tunnelIP4DstMask)), /* tunnel_ipv4_dst-mask */
-				intEnc(uint64(p.tunnelTEIDMask)),   /* enb_teid-mask */
-				intEnc(uint64(p.srcIPMask)),        /* ueaddr ip-mask */
-				intEnc(uint64(p.dstIPMask)),        /* inet ip-mask */
-				intEnc(uint64(p.srcPortMask)),      /* ue port-mask */
-				intEnc(uint64(p.dstPortMask)),      /* inet port-mask */
-				intEnc(uint64(p.protoMask)),        /* proto id-mask */
-			},
+		// delete_bulk only looks at values and masks
+		f := &pb.WildcardMatchConfig{}
+		for _, p := range pdrs {
+			r := pdrRule(p)
+			f.Rules = append(f.Rules, &pb.WildcardMatchCommandAddArg{
+				Values: r.Values,
+				Masks:  r.Masks,
+			})
 		}
-		any, err = anypb.New(f)
+
+		any, err := anypb.New(f)
 		if err != nil {
-			log.Println("Error marshalling the rule", f, err)
+			log.Println("Error marshalling the rules", f, err)
 			return
 		}
 
-		b.processPDR(ctx, any, "delete")
+		b.processPDR(ctx, any, "delete_bulk")
 		done <- true
 	}()
 }
 
 func (b *bess) processQER(ctx context.Context, any *anypb.Any, method string) {
-	if method != "add" && method != "delete" && method != "clear" {
+	switch method {
+	case "add", "delete", "add_bulk", "delete_bulk", "clear":
+	default:
 		log.Println("Invalid method name: ", method)
 		return
 	}
 
+	module := "qerLookup"
+	if b.fused {
+		module = "pdrLookup"
+		method = "qer_" + method
+	}
+
 	_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
-		Name: "qerLookup",
+		Name: module,
 		Cmd:  method,
 		Arg:  any,
 	})
 	if err != nil {
-		log.Println("qerLookup method failed!:", err)
+		log.Println(module, method, "failed!:", err)
+	}
+}
+
+func qerRule(qer qer) *pb.ExactMatchCommandAddArg {
+	return &pb.ExactMatchCommandAddArg{
+		Gate: uint64(0),
+		Fields: []*pb.FieldData{
+			intEnc(uint64(qer.qerID)), /* qer_id */
+			intEnc(uint64(qer.fseID)), /* fseid */
+		},
+		Values: []*pb.FieldData{
+			intEnc(uint64(qer.qfi)),      /* action */
+			intEnc(uint64(qer.ulStatus)), /* QFI */
+			intEnc(uint64(qer.dlStatus)), /* tunnel_out_type */
+			intEnc(uint64(qer.ulMbr)),    /* access-ip */
+			intEnc(uint64(qer.dlMbr)),    /* enb ip */
+			intEnc(uint64(qer.ulGbr)),    /* enb teid */
+			intEnc(uint64(qer.dlGbr)),    /* udp gtpu port */
+		},
 	}
 }
 
-func (b *bess) addQER(ctx context.Context, done chan<- bool, qer qer) {
+func (b *bess) addQERs(ctx context.Context, done chan<- bool, qers []qer) {
 	go func() {
-		var any *anypb.Any
-		var err error
-		q := &pb.ExactMatchCommandAddArg{
-			Gate: uint64(0),
-			Fields: []*pb.FieldData{
-				intEnc(uint64(qer.qerID)), /* far_id */
-				intEnc(uint64(qer.fseID)), /* fseid */
-			},
-			Values: []*pb.FieldData{
-				intEnc(uint64(qer.qfi)),      /* action */
-				intEnc(uint64(qer.ulStatus)), /* QFI */
-				intEnc(uint64(qer.dlStatus)), /* tunnel_out_type */
-				intEnc(uint64(qer.ulMbr)),    /* access-ip */
-				intEnc(uint64(qer.dlMbr)),    /* enb ip */
-				intEnc(uint64(qer.ulGbr)),    /* enb teid */
-				intEnc(uint64(qer.dlGbr)),    /* udp gtpu port */
-			},
-		}
-		any, err = anypb.New(q)
+		q := &pb.ExactMatchConfig{}
+		for _, qer := range qers {
+			q.Rules = append(q.Rules, qerRule(qer))
+		}
+
+		any, err := anypb.New(q)
 		if err != nil {
-			log.Println("Error marshalling the rule", q, err)
+			log.Println("Error marshalling the rules", q, err)
 			return
 		}
-		b.processQER(ctx, any, "add")
+		b.processQER(ctx, any, "add_bulk")
 		done <- true
 	}()
 }
 
-func (b *bess) delQER(ctx context.Context, done chan<- bool, qer qer) {
+func (b *bess) delQERs(ctx context.Context, done chan<- bool, qers []qer) {
 	go func() {
-		var any *anypb.Any
-		var err error
-
-		q := &pb.ExactMatchCommandDeleteArg{
-			Fields: []*pb.FieldData{
-				intEnc(uint64(qer.qerID)), /* qer_id */
-				intEnc(uint64(qer.fseID)), /* fseid */
-			},
+		// delete_bulk only looks at fields
+		q := &pb.ExactMatchConfig{}
+		for _, qer := range qers {
+			q.Rules = append(q.Rules, &pb.ExactMatchCommandAddArg{
+				Fields: qerRule(qer).Fields,
+			})
 		}
-		any, err = anypb.New(q)
+
+		any, err := anypb.New(q)
 		if err != nil {
-			log.Println("Error marshalling the rule", q, err)
+			log.Println("Error marshalling the rules", q, err)
 			return
 		}
-		b.processQER(ctx, any, "delete")
+		b.processQER(ctx, any, "delete_bulk")
 		done <- true
 	}()
 }
 
 func (b *bess) processFAR(ctx context.Context, any *anypb.Any, method string) {
-	if method != "add" && method != "delete" && method != "clear" {
+	switch method {
+	case "add", "delete", "add_bulk", "delete_bulk", "clear":
+	default:
 		log.Println("Invalid method name: ", method)
 		return
 	}
 
+	module := "farLookup"
+	if b.fused {
+		module = "pdrLookup"
+		method = "far_" + method
+	}
+
 	_, err := b.client.ModuleCommand(ctx, &pb.CommandRequest{
-		Name: "farLookup",
+		Name: module,
 		Cmd:  method,
 		Arg:  any,
 	})
 	if err != nil {
-		log.Println("farLookup method failed!:", err)
+		log.Println(module, method, "failed!:", err)
+	}
+}
+
+func farRule(far far) *pb.ExactMatchCommandAddArg {
+	action := far.setActionValue()
+	return &pb.ExactMatchCommandAddArg{
+		Gate: uint64(far.tunnelType),
+		Fields: []*pb.FieldData{
+			intEnc(uint64(far.farID)), /* far_id */
+			intEnc(uint64(far.fseID)), /* fseid */
+		},
+		Values: []*pb.FieldData{
+			intEnc(uint64(action)),           /* action */
+			intEnc(uint64(far.tunnelType)),   /* tunnel_out_type */
+			intEnc(uint64(far.tunnelIP4Src)), /* access-ip */
+			intEnc(uint64(far.tunnelIP4Dst)), /* enb ip */
+			intEnc(uint64(far.tunnelTEID)),   /* enb teid */
+			intEnc(uint64(far.tunnelPort)),   /* udp gtpu port */
+		},
 	}
 }
 
-func (b *bess) addFAR(ctx context.Context, done chan<- bool, far far) {
+func (b *bess) addFARs(ctx context.Context, done chan<- bool, fars []far) {
 	go func() {
-		var any *anypb.Any
-		var err error
-		action := far.setActionValue()
-		f := &pb.ExactMatchCommandAddArg{
-			Gate: uint64(far.tunnelType),
-			Fields: []*pb.FieldData{
-				intEnc(uint64(far.farID)), /* far_id */
-				intEnc(uint64(far.fseID)), /* fseid */
-			},
-			Values: []*pb.FieldData{
-				intEnc(uint64(action)),           /* action */
-				intEnc(uint64(far.tunnelType)),   /* tunnel_out_type */
-				intEnc(uint64(far.tunnelIP4Src)), /* access-ip */
-				intEnc(uint64(far.tunnelIP4Dst)), /* enb ip */
-				intEnc(uint64(far.tunnelTEID)),   /* enb teid */
-				intEnc(uint64(far.tunnelPort)),   /* udp gtpu port */
-			},
+		f := &pb.ExactMatchConfig{}
+		for _, far := range fars {
+			f.Rules = append(f.Rules, farRule(far))
 		}
-		any, err = anypb.New(f)
+
+		any, err := anypb.New(f)
 		if err != nil {
-			log.Println("Error marshalling the rule", f, err)
+			log.Println("Error marshalling the rules", f, err)
 			return
 		}
-		b.processFAR(ctx, any, "add")
+		b.processFAR(ctx, any, "add_bulk")
 		done <- true
 	}()
 }
 
-func (b *bess) delFAR(ctx context.Context, done chan<- bool, far far) {
+func (b *bess) delFARs(ctx context.Context, done chan<- bool, fars []far) {
 	go func() {
-		var any *anypb.Any
-		var err error
-
-		f := &pb.ExactMatchCommandDeleteArg{
-			Fields: []*pb.FieldData{
-				intEnc(uint64(far.farID)), /* far_id */
-				intEnc(uint64(far.fseID)), /* fseid */
-			},
+		// delete_bulk only looks at fields
+		f := &pb.ExactMatchConfig{}
+		for _, far := range fars {
+			f.Rules = append(f.Rules, &pb.ExactMatchCommandAddArg{
+				Fields: farRule(far).Fields,
+			})
 		}
-		any, err = anypb.New(f)
+
+		any, err := anypb.New(f)
 		if err != nil {
-			log.Println("Error marshalling the rule", f, err)
+			log.Println("Error marshalling the rules", f, err)
 			return
 		}
-		b.processFAR(ctx, any, "delete")
+		b.processFAR(ctx, any, "delete_bulk")
 		done <- true
 	}()
 }
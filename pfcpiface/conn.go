@@ -146,6 +146,7 @@ func pfcpifaceMainLoop(upf *upf, accessIP, coreIP, sourceIP, smfName string) {
 		case message.MsgTypeAssociationSetupRequest:
 			cleanupSessions()
 			go readReportNotification(upf.reportNotifyChan, &pconn, conn, addr)
+			go readGtpuSignals(upf, &pconn, conn, addr)
 			upf.setInfo(conn, addr, &pconn)
 			outgoingMessage = pconn.handleAssociationSetupRequest(upf, msg, addr, sourceIP, accessIP, coreIP)
 			if outgoingMessage != nil {
@@ -27,4 +27,6 @@ type fastPath interface {
 	isConnected(accessIP *net.IP) bool
 	summaryLatencyJitter(uc *upfCollector, ch chan<- prometheus.Metric)
 	portStats(uc *upfCollector, ch chan<- prometheus.Metric)
+	moduleStats(uc *upfCollector, ch chan<- prometheus.Metric)
+	pipelineDrops(uc *upfCollector, ch chan<- prometheus.Metric)
 }
@@ -25,20 +25,27 @@ var (
 
 // Conf : Json conf struct
 type Conf struct {
-	Mode              string      `json:"mode"`
-	MaxSessions       uint32      `json:"max_sessions"`
-	AccessIface       IfaceType   `json:"access"`
-	CoreIface         IfaceType   `json:"core"`
-	CPIface           CPIfaceInfo `json:"cpiface"`
-	P4rtcIface        P4rtcInfo   `json:"p4rtciface"`
-	EnableP4rt        bool        `json:"enable_p4rt"`
-	SimInfo           SimModeInfo `json:"sim"`
-	ConnTimeout       uint32      `json:"conn_timeout"`
-	ReadTimeout       uint32      `json:"read_timeout"`
-	EnableNotifyBess  bool        `json:"enable_notify_bess"`
-	EnableEndMarker   bool        `json:"enable_end_marker"`
-	NotifySockAddr    string      `json:"notify_sockaddr"`
-	EndMarkerSockAddr string      `json:"endmarker_sockaddr"`
+	Mode               string      `json:"mode"`
+	MaxSessions        uint32      `json:"max_sessions"`
+	AccessIface        IfaceType   `json:"access"`
+	CoreIface          IfaceType   `json:"core"`
+	CPIface            CPIfaceInfo `json:"cpiface"`
+	P4rtcIface         P4rtcInfo   `json:"p4rtciface"`
+	EnableP4rt         bool        `json:"enable_p4rt"`
+	SimInfo            SimModeInfo `json:"sim"`
+	ConnTimeout        uint32      `json:"conn_timeout"`
+	ReadTimeout        uint32      `json:"read_timeout"`
+	EnableNotifyBess   bool        `json:"enable_notify_bess"`
+	EnableEndMarker    bool        `json:"enable_end_marker"`
+	NotifySockAddr     string      `json:"notify_sockaddr"`
+	EndMarkerSockAddr  string      `json:"endmarker_sockaddr"`
+	TwoStagePdr        bool        `json:"two_stage_pdr"`
+	FusedSessionTable  bool        `json:"fused_session_table"`
+	SessionFilter      bool        `json:"session_filter"`
+	DlBuffer           bool        `json:"dl_buffer"`
+	DdnHolddownMs      uint32      `json:"ddn_holddown_ms"`
+	EndMarkerModule    bool        `json:"end_marker_module"`
+	GtpuSignalSockAddr string      `json:"gtpu_signal_sockaddr"`
 }
 
 // SimModeInfo : Sim mode attributes
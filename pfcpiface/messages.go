@@ -234,6 +234,9 @@ func (pc *PFCPConn) handlePFDMgmtRequest(upf *upf, msg message.Message, addr net
 }
 
 func (pc *PFCPConn) handleSessionReportResponse(upf *upf, msg message.Message, addr net.Addr) {
+	pc.mgr.mux.Lock()
+	defer pc.mgr.mux.Unlock()
+
 	log.Println("Got session report response from: ", addr)
 	srres, ok := msg.(*message.SessionReportResponse)
 	if !ok {
@@ -266,6 +269,9 @@ func (pc *PFCPConn) handleSessionReportResponse(upf *upf, msg message.Message, a
 }
 
 func (pc *PFCPConn) handleSessionEstablishmentRequest(upf *upf, msg message.Message, addr net.Addr, sourceIP string) []byte {
+	pc.mgr.mux.Lock()
+	defer pc.mgr.mux.Unlock()
+
 	sereq, ok := msg.(*message.SessionEstablishmentRequest)
 	if !ok {
 		log.Println("Got an unexpected message: ", msg.MessageTypeName(), " from: ", addr)
@@ -380,6 +386,9 @@ func (pc *PFCPConn) handleSessionEstablishmentRequest(upf *upf, msg message.Mess
 }
 
 func (pc *PFCPConn) handleSessionModificationRequest(upf *upf, msg message.Message, addr net.Addr, sourceIP string) []byte {
+	pc.mgr.mux.Lock()
+	defer pc.mgr.mux.Unlock()
+
 	smreq, ok := msg.(*message.SessionModificationRequest)
 	if !ok {
 		log.Println("Got an unexpected message: ", msg.MessageTypeName(), " from: ", addr)
@@ -588,6 +597,9 @@ func (pc *PFCPConn) handleSessionModificationRequest(upf *upf, msg message.Messa
 }
 
 func (pc *PFCPConn) handleSessionDeletionRequest(upf *upf, msg message.Message, addr net.Addr, sourceIP string) []byte {
+	pc.mgr.mux.Lock()
+	defer pc.mgr.mux.Unlock()
+
 	sdreq, ok := msg.(*message.SessionDeletionRequest)
 	if !ok {
 		log.Println("Got an unexpected message: ", msg.MessageTypeName(), " from: ", addr)
@@ -747,6 +759,9 @@ func handleDigestReport(fseid uint64,
 	pfcpConn *PFCPConn,
 	udpConn *net.UDPConn,
 	udpAddr net.Addr) {
+	pfcpConn.mgr.mux.RLock()
+	defer pfcpConn.mgr.mux.RUnlock()
+
 	session, ok := pfcpConn.mgr.sessions[fseid]
 	if !ok {
 		log.Println("No session found for fseid : ", fseid)
@@ -797,3 +812,87 @@ func handleDigestReport(fseid uint64,
 		}
 	}
 }
+
+func readGtpuSignals(upf *upf, pfcpConn *PFCPConn,
+	udpConn *net.UDPConn, udpAddr net.Addr) {
+	log.Println("read GTP-U signalling start")
+	for sig := range upf.gtpuSignalChan {
+		switch sig.msgType {
+		case gtpuErrorIndication:
+			handleErrorIndication(sig, pfcpConn, udpConn, udpAddr)
+		case gtpuEndMarker:
+			relayEndMarker(sig, upf, pfcpConn)
+		}
+	}
+}
+
+// handleErrorIndication reports the session whose FAR sends on the tunnel
+// in error to the SMF
+func handleErrorIndication(sig gtpuSignal,
+	pfcpConn *PFCPConn,
+	udpConn *net.UDPConn,
+	udpAddr net.Addr) {
+	pfcpConn.mgr.mux.RLock()
+	defer pfcpConn.mgr.mux.RUnlock()
+
+	for _, session := range pfcpConn.mgr.sessions {
+		for _, far := range session.fars {
+			if far.tunnelIP4Dst != sig.ip || far.tunnelTEID != sig.teid {
+				continue
+			}
+
+			seq := pfcpConn.getSeqNum()
+			serep := message.NewSessionReportRequest(0, 0, 0, seq, 0,
+				ie.NewReportType(0, 1, 0, 0), /*upir, erir, usar, dldr int*/
+				ie.NewErrorIndicationReport(
+					ie.NewFTEID(sig.teid, int2ip(sig.ip), nil, nil)),
+			)
+			serep.Header.SEID = session.remoteSEID
+
+			ret, err := serep.Marshal()
+			if err != nil {
+				log.Println("Marshal function failed for SM resp ", err)
+				return
+			}
+			if _, err := udpConn.WriteTo(ret, udpAddr); err != nil {
+				log.Println("Unable to transmit Report req", err)
+			}
+
+			return
+		}
+	}
+
+	log.Println("No FAR found for error indication, TEID:", sig.teid)
+}
+
+// relayEndMarker sends an end marker on the tunnel of the FAR of the PDR
+// that matches the tunnel the end marker came on
+func relayEndMarker(sig gtpuSignal, upf *upf, pfcpConn *PFCPConn) {
+	pfcpConn.mgr.mux.RLock()
+	defer pfcpConn.mgr.mux.RUnlock()
+
+	for _, session := range pfcpConn.mgr.sessions {
+		for _, pdr := range session.pdrs {
+			if pdr.tunnelTEIDMask == 0 || pdr.tunnelTEID != sig.teid ||
+				(pdr.tunnelIP4DstMask != 0 && pdr.tunnelIP4Dst != sig.ip) {
+				continue
+			}
+
+			for _, far := range session.fars {
+				if far.farID != pdr.farID || far.tunnelTEID == 0 {
+					continue
+				}
+
+				var endMarkerList [][]byte
+				addEndMarker(far, &endMarkerList)
+				if err := upf.sendEndMarkers(&endMarkerList); err != nil {
+					log.Println("Sending End Markers Failed : ", err)
+				}
+
+				return
+			}
+		}
+	}
+
+	log.Println("No PDR/FAR found for end marker, TEID:", sig.teid)
+}
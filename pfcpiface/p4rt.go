@@ -62,6 +62,12 @@ func (p *p4rtc) summaryLatencyJitter(uc *upfCollector, ch chan<- prometheus.Metr
 func (p *p4rtc) portStats(uc *upfCollector, ch chan<- prometheus.Metric) {
 }
 
+func (p *p4rtc) moduleStats(uc *upfCollector, ch chan<- prometheus.Metric) {
+}
+
+func (p *p4rtc) pipelineDrops(uc *upfCollector, ch chan<- prometheus.Metric) {
+}
+
 func setSwitchInfo(p4rtClient *P4rtClient) (net.IP, net.IPMask, error) {
 	log.Println("Set Switch Info")
 	log.Println("device id ", (*p4rtClient).DeviceID)
@@ -244,6 +250,8 @@ func (p *p4rtc) isConnected(accessIP *net.IP) bool {
 func (p *p4rtc) sendDeleteAllSessionsMsgtoUPF() {
 	log.Println("Loop through sessions and delete all entries p4")
 	if (p.pfcpConn != nil) && (p.pfcpConn.mgr != nil) {
+		p.pfcpConn.mgr.mux.Lock()
+		defer p.pfcpConn.mgr.mux.Unlock()
 		for seidKey, value := range p.pfcpConn.mgr.sessions {
 			p.sendMsgToUPF("del", value.pdrs, value.fars, nil)
 			p.pfcpConn.mgr.RemoveSession(seidKey)
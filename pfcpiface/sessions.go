@@ -16,6 +16,9 @@ type PFCPSessionMgr struct {
 	maxRetries int
 	appPFDs    map[string]appPFD
 	sessions   map[uint64]*PFCPSession
+	// sessions and their rules are changed by the main loop under mux,
+	// and read by the other goroutines under mux.RLock
+	mux sync.RWMutex
 }
 
 // PFD holds the switch level application IDs
@@ -65,6 +65,13 @@ type upfCollector struct {
 	latency *prometheus.Desc
 	jitter  *prometheus.Desc
 
+	moduleBatchCycles  *prometheus.Desc
+	modulePacketCycles *prometheus.Desc
+	moduleBatchSize    *prometheus.Desc
+	moduleGatePackets  *prometheus.Desc
+
+	pipelineDropped *prometheus.Desc
+
 	upf *upf
 }
 
@@ -90,6 +97,26 @@ func newUpfCollector(upf *upf) *upfCollector {
 			"Shows the packet processing jitter percentiles in UPF",
 			[]string{"iface"}, nil,
 		),
+		moduleBatchCycles: prometheus.NewDesc(prometheus.BuildFQName("upf", "module", "batch_cycles"),
+			"Shows the TSC cycles a UPF module spends per batch",
+			[]string{"module"}, nil,
+		),
+		modulePacketCycles: prometheus.NewDesc(prometheus.BuildFQName("upf", "module", "packet_cycles"),
+			"Shows the TSC cycles a UPF module spends per packet, averaged over its batch",
+			[]string{"module"}, nil,
+		),
+		moduleBatchSize: prometheus.NewDesc(prometheus.BuildFQName("upf", "module", "batch_size"),
+			"Shows the sizes of the batches a UPF module processes",
+			[]string{"module"}, nil,
+		),
+		moduleGatePackets: prometheus.NewDesc(prometheus.BuildFQName("upf", "module", "gate_packets"),
+			"Shows the number of packets a UPF module emitted per output gate",
+			[]string{"module", "gate"}, nil,
+		),
+		pipelineDropped: prometheus.NewDesc(prometheus.BuildFQName("upf", "pipeline_drops", "count"),
+			"Shows the number of packets the UPF pipeline dropped per reason",
+			[]string{"reason"}, nil,
+		),
 		upf: upf,
 	}
 }
@@ -103,12 +130,21 @@ func (uc *upfCollector) Describe(ch chan<- *prometheus.Desc) {
 
 	ch <- uc.latency
 	ch <- uc.jitter
+
+	ch <- uc.moduleBatchCycles
+	ch <- uc.modulePacketCycles
+	ch <- uc.moduleBatchSize
+	ch <- uc.moduleGatePackets
+
+	ch <- uc.pipelineDropped
 }
 
 //Collect writes all metrics to prometheus metric channel
 func (uc *upfCollector) Collect(ch chan<- prometheus.Metric) {
 	uc.summaryLatencyJitter(ch)
 	uc.portStats(ch)
+	uc.moduleStats(ch)
+	uc.pipelineDrops(ch)
 }
 
 func (uc *upfCollector) portStats(ch chan<- prometheus.Metric) {
@@ -120,6 +156,15 @@ func (uc *upfCollector) summaryLatencyJitter(ch chan<- prometheus.Metric) {
 	uc.upf.intf.summaryLatencyJitter(uc, ch)
 }
 
+func (uc *upfCollector) moduleStats(ch chan<- prometheus.Metric) {
+	// Only modules that have set_stats enabled report anything
+	uc.upf.intf.moduleStats(uc, ch)
+}
+
+func (uc *upfCollector) pipelineDrops(ch chan<- prometheus.Metric) {
+	uc.upf.intf.pipelineDrops(uc, ch)
+}
+
 func setupProm(upf *upf) {
 	uc := newUpfCollector(upf)
 	prometheus.MustRegister(uc)
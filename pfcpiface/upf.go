@@ -29,6 +29,15 @@ type upf struct {
 	recoveryTime     time.Time
 	dnn              string
 	reportNotifyChan chan uint64
+	gtpuSignalChan   chan gtpuSignal
+}
+
+// gtpuSignal is a GTP-U signalling message the fastpath passed up: the
+// tunnel in error of an error indication, or the tunnel an end marker came on
+type gtpuSignal struct {
+	msgType uint8
+	ip      uint32
+	teid    uint32
 }
 
 // to be replaced with go-pfcp structs
@@ -46,6 +55,10 @@ const (
 	n6 = 0x1
 	n9 = 0x2
 
+	// GTP-U signalling message types
+	gtpuErrorIndication = 26
+	gtpuEndMarker       = 254
+
 	// far-action specific values
 	farForwardD = 0x0
 	farForwardU = 0x1
@@ -80,6 +93,7 @@ func (u *upf) sim(method string) {
 
 func (u *upf) setUpfInfo(conf *Conf) {
 	u.reportNotifyChan = make(chan uint64, 1024)
+	u.gtpuSignalChan = make(chan gtpuSignal, 1024)
 	u.n4SrcIP = net.ParseIP("0.0.0.0")
 	u.nodeIP = net.ParseIP("0.0.0.0")
 